@@ -0,0 +1,154 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for AllocationTracker class, and replacements of the global allocation functions.
+//
+
+#include "allocation_tracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif  // defined(__GLIBC__)
+
+std::atomic<bool> AllocationTracker::is_enabled_{false};
+
+namespace {
+/**
+ * @brief Allocation statistics of the current thread. Plain integers, so that they can be used before any
+ * initialization of the thread.
+ */
+thread_local std::uint64_t thread_count = 0;
+thread_local std::uint64_t thread_bytes = 0;
+thread_local std::int64_t thread_live_bytes = 0;
+thread_local std::int64_t thread_peak_live_bytes = 0;
+
+/**
+ * @brief Gets the number of bytes actually reserved for an allocation.
+ *
+ * @param ptr Allocated memory
+ * @return Size in bytes
+ */
+auto GetAllocationSize(void* ptr) -> std::size_t {
+#if defined(__GLIBC__)
+  return malloc_usable_size(ptr);
+#else
+  static_cast<void>(ptr);
+  return 0;
+#endif  // defined(__GLIBC__)
+}
+}  // namespace
+
+void AllocationTracker::Enable() {
+#if defined(__GLIBC__)
+  is_enabled_ = true;
+#else
+  throw std::runtime_error("Allocation tracking is not supported on this platform");
+#endif  // defined(__GLIBC__)
+}
+
+auto AllocationTracker::GetThreadStats() -> Stats {
+  return {thread_count, thread_bytes, thread_live_bytes, thread_peak_live_bytes};
+}
+
+auto AllocationTracker::ResetThreadPeak() -> std::int64_t {
+  const std::int64_t peak_live_bytes = thread_peak_live_bytes;
+  thread_peak_live_bytes = thread_live_bytes;
+  return peak_live_bytes;
+}
+
+void AllocationTracker::RestoreThreadPeak(std::int64_t peak_live_bytes) {
+  thread_peak_live_bytes = std::max(thread_peak_live_bytes, peak_live_bytes);
+}
+
+void AllocationTracker::RecordAllocation(void* const ptr) {
+  const auto size = static_cast<std::int64_t>(GetAllocationSize(ptr));
+  ++thread_count;
+  thread_bytes += static_cast<std::uint64_t>(size);
+  thread_live_bytes += size;
+  thread_peak_live_bytes = std::max(thread_peak_live_bytes, thread_live_bytes);
+}
+
+void AllocationTracker::RecordDeallocation(void* const ptr) {
+  thread_live_bytes -= static_cast<std::int64_t>(GetAllocationSize(ptr));
+}
+
+namespace {
+/**
+ * @brief Allocates memory as the default @c operator @c new does, calling the new handler until it succeeds.
+ *
+ * @param size Size in bytes
+ * @return Allocated memory, or @c nullptr if there is no new handler
+ */
+auto Allocate(std::size_t size) -> void* {
+  if (size == 0) {
+    size = 1;
+  }
+
+  void* ptr = nullptr;
+  while ((ptr = std::malloc(size)) == nullptr) {
+    const std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    handler();
+  }
+
+  if (AllocationTracker::IsEnabled()) {
+    AllocationTracker::RecordAllocation(ptr);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Frees memory allocated by @c Allocate.
+ *
+ * @param ptr Memory to free
+ */
+void Deallocate(void* const ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  if (AllocationTracker::IsEnabled()) {
+    AllocationTracker::RecordDeallocation(ptr);
+  }
+  std::free(ptr);
+}
+}  // namespace
+
+auto operator new(std::size_t size) -> void* {
+  void* ptr = Allocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+auto operator new[](std::size_t size) -> void* {
+  void* ptr = Allocate(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+auto operator new(std::size_t size, const std::nothrow_t&) noexcept -> void* { return Allocate(size); }
+
+auto operator new[](std::size_t size, const std::nothrow_t&) noexcept -> void* { return Allocate(size); }
+
+void operator delete(void* ptr) noexcept { Deallocate(ptr); }
+
+void operator delete[](void* ptr) noexcept { Deallocate(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { Deallocate(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { Deallocate(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { Deallocate(ptr); }
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { Deallocate(ptr); }
@@ -0,0 +1,87 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for tracking heap allocations.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_ALLOCATION_TRACKER_H_
+#define WARFRAME_PACKAGES_DEPARSER_ALLOCATION_TRACKER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Static tracker of heap allocations made through the global @c operator @c new and @c operator @c delete.
+ *
+ * Each thread counts its own allocations, along with the bytes it currently holds and the peak of those bytes. Memory
+ * freed by another thread than the one which allocated it is subtracted from the freeing thread, so the live bytes of a
+ * single thread may become negative.
+ *
+ * Tracking is only supported with glibc, where the size of an allocation can be queried with @c malloc_usable_size.
+ */
+class AllocationTracker {
+ public:
+  /**
+   * @brief Allocation statistics of a thread.
+   */
+  struct Stats {
+    std::uint64_t count;
+    std::uint64_t bytes;
+    std::int64_t live_bytes;
+    std::int64_t peak_live_bytes;
+  };
+
+  AllocationTracker() = delete;
+  AllocationTracker(AllocationTracker&&) = delete;
+  AllocationTracker(const AllocationTracker&) = delete;
+  auto operator=(AllocationTracker&&) noexcept -> AllocationTracker& = delete;
+  auto operator=(const AllocationTracker&) -> AllocationTracker& = delete;
+  ~AllocationTracker() = delete;
+
+  /**
+   * Enables tracking of all subsequent allocations.
+   *
+   * @throw @c std::runtime_error if tracking is not supported on this platform
+   */
+  static void Enable();
+  /**
+   * @return Whether tracking is enabled
+   */
+  static auto IsEnabled() -> bool { return is_enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @return Allocation statistics of the current thread
+   */
+  static auto GetThreadStats() -> Stats;
+  /**
+   * Starts measuring a new peak of live bytes in the current thread, from the bytes it currently holds.
+   *
+   * @return Previous peak, to be passed to @c RestoreThreadPeak
+   */
+  static auto ResetThreadPeak() -> std::int64_t;
+  /**
+   * Restores the peak of live bytes in the current thread which was replaced by @c ResetThreadPeak.
+   *
+   * @param peak_live_bytes Value returned by the matching @c ResetThreadPeak
+   */
+  static void RestoreThreadPeak(std::int64_t peak_live_bytes);
+
+  /**
+   * Records an allocation of the current thread. Called by @c operator @c new.
+   *
+   * @param ptr Allocated memory
+   */
+  static void RecordAllocation(void* ptr);
+  /**
+   * Records a deallocation of the current thread. Called by @c operator @c delete.
+   *
+   * @param ptr Memory to be freed
+   */
+  static void RecordDeallocation(void* ptr);
+
+ private:
+  static std::atomic<bool> is_enabled_;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_ALLOCATION_TRACKER_H_
@@ -0,0 +1,346 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// This file compares two sets of benchmark results, and flags significant regressions.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_results.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+namespace {
+/**
+ * @brief Largest number of samples per side for which the exact distribution of the U statistic is used.
+ */
+constexpr std::size_t kExactSampleLimit = 20;
+
+/**
+ * @brief List of program options.
+ */
+struct {
+  std::string old_filename = "";
+  std::string new_filename = "";
+  /**
+   * @brief Largest allowed slowdown of the median in percent, unless overridden for a benchmark.
+   */
+  double threshold = 5.0;
+  /**
+   * @brief Allowed slowdowns of specific benchmarks in percent.
+   */
+  std::map<std::string, double> budgets;
+  /**
+   * @brief Significance level of the test.
+   */
+  double alpha = 0.05;
+} program_args;
+
+/**
+ * @brief Computes the Mann-Whitney U statistic, i.e. the number of pairs in which the sample of @p b is larger.
+ *
+ * @param a First set of samples
+ * @param b Second set of samples
+ * @return U statistic, where ties count as one half
+ */
+auto GetUStatistic(const std::vector<double>& a, const std::vector<double>& b) -> double {
+  double u = 0.0;
+  for (auto x : a) {
+    for (auto y : b) {
+      if (y > x) {
+        u += 1.0;
+      } else if (!(y < x)) {
+        u += 0.5;
+      }
+    }
+  }
+  return u;
+}
+
+/**
+ * @brief Computes the one-sided p-value of the Mann-Whitney U test, that samples of @p b tend to be larger than
+ * samples of @p a.
+ *
+ * Small sets of samples use the exact distribution of U, and larger ones use its normal approximation.
+ *
+ * @param a First set of samples
+ * @param b Second set of samples
+ * @return p-value
+ */
+auto GetPValue(const std::vector<double>& a, const std::vector<double>& b) -> double {
+  const std::size_t n = a.size();
+  const std::size_t m = b.size();
+  if (n == 0 || m == 0) {
+    return 1.0;
+  }
+  const double u = GetUStatistic(a, b);
+
+  if (n <= kExactSampleLimit && m <= kExactSampleLimit) {
+    // counts[i][j][k] is the number of orderings of i samples of a and j samples of b with U = k
+    const std::size_t max_u = n * m;
+    auto counts = std::vector<std::vector<std::vector<double>>>(
+        n + 1, std::vector<std::vector<double>>(m + 1, std::vector<double>(max_u + 1, 0.0)));
+    for (std::size_t i = 0; i <= n; ++i) {
+      for (std::size_t j = 0; j <= m; ++j) {
+        if (i == 0 || j == 0) {
+          counts[i][j][0] = 1.0;
+          continue;
+        }
+        for (std::size_t k = 0; k <= i * j; ++k) {
+          // the largest sample is either from b, which is larger than all i samples of a, or from a
+          counts[i][j][k] = (k >= i ? counts[i][j - 1][k - i] : 0.0) + counts[i - 1][j][k];
+        }
+      }
+    }
+
+    double total = 0.0;
+    double tail = 0.0;
+    for (std::size_t k = 0; k <= max_u; ++k) {
+      total += counts[n][m][k];
+      if (static_cast<double>(k) >= std::ceil(u)) {
+        tail += counts[n][m][k];
+      }
+    }
+    return tail / total;
+  }
+
+  const auto nn = static_cast<double>(n);
+  const auto mm = static_cast<double>(m);
+  const double mean = nn * mm / 2.0;
+  const double sd = std::sqrt(nn * mm * (nn + mm + 1.0) / 12.0);
+  const double z = (u - mean - 0.5) / sd;
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+/**
+ * @brief Computes the smallest p-value which the test can return for sets of samples of the given sizes, i.e. when
+ * every sample of one set is larger than every sample of the other.
+ *
+ * @param n Number of samples of the first set
+ * @param m Number of samples of the second set
+ * @return Smallest possible p-value
+ */
+auto GetMinimumPValue(std::size_t n, std::size_t m) -> double {
+  return GetPValue(std::vector<double>(n, 0.0), std::vector<double>(m, 1.0));
+}
+
+/**
+ * @brief Finds the number of repetitions each side needs for the test to be able to go below a significance level.
+ *
+ * @param alpha Significance level
+ * @return Number of repetitions, or 0 if no reasonable number suffices
+ */
+auto GetRequiredRepetitions(double alpha) -> std::size_t {
+  constexpr std::size_t kMaxRepetitions = 1000;
+  for (std::size_t k = 1; k <= kMaxRepetitions; ++k) {
+    if (GetMinimumPValue(k, k) < alpha) {
+      return k;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Reads a results file.
+ *
+ * @param filename Name of the file
+ * @return Results
+ *
+ * @throw @c std::runtime_error if the file cannot be read
+ */
+auto ReadFile(const std::string& filename) -> BenchmarkResults {
+  auto ifs = std::ifstream(filename);
+  if (!ifs) {
+    throw std::runtime_error(filename + ": Cannot open file");
+  }
+  try {
+    return ReadResults(ifs);
+  } catch (std::runtime_error& ex_runtime) {
+    throw std::runtime_error(filename + ": " + ex_runtime.what());
+  }
+}
+
+/**
+ * @brief Warns about differences between the conditions of two sets of results.
+ *
+ * @param old_results Baseline results
+ * @param new_results Results to compare
+ */
+void CheckConditions(const BenchmarkResults& old_results, const BenchmarkResults& new_results) {
+  const auto& o = old_results.environment;
+  const auto& n = new_results.environment;
+  if (o.host != n.host || o.cpu != n.cpu || o.cpu_count != n.cpu_count) {
+    cerr << "Warning: Results are from different machines (" << o.host << ", " << o.cpu << " vs " << n.host << ", "
+         << n.cpu << ")" << endl;
+  }
+  if (o.compiler != n.compiler || o.build_type != n.build_type) {
+    cerr << "Warning: Results are from different builds (" << o.compiler << " " << o.build_type << " vs "
+         << n.compiler << " " << n.build_type << ")" << endl;
+  }
+  if (old_results.input.bytes != new_results.input.bytes || old_results.input.seed != new_results.input.seed) {
+    cerr << "Warning: Results are from different inputs (" << old_results.input.bytes << " bytes, seed "
+         << old_results.input.seed << " vs " << new_results.input.bytes << " bytes, seed " << new_results.input.seed
+         << ")" << endl;
+  }
+}
+
+/**
+ * @brief Outputs help text.
+ *
+ * @param s Name of the application
+ */
+void OutputHelp(const std::string& s) {
+  std::string message;
+  message += "Usage: " + s + " [OPTION]... [OLD_RESULTS] [NEW_RESULTS]\n";
+  message += "Compares two results files written by warframe_packages_bench --json.\n\n";
+  message += "      --threshold=[PCT]\tflag slowdowns of the median above [PCT] percent (default: 5)\n";
+  message += "      --budget=[NAME]=[PCT]\tallow benchmark [NAME] to slow down by [PCT] percent instead\n";
+  message += "      --alpha=[P]\t\tsignificance level of the test (default: 0.05)\n";
+  message += "      --help\t\tdisplay this help and exit\n\n";
+  message += "Exits with status 1 if any benchmark has regressed significantly beyond its budget, and with status 2\n";
+  message += "if a benchmark has too few repetitions for any regression to be significant at [P].\n";
+
+  cout << message << endl;
+}
+
+/**
+ * @brief Parse all arguments in the command line.
+ *
+ * @param args Vector of arguments
+ * @return True if the results should be compared
+ */
+auto ReadArgs(const std::vector<std::string>& args) -> bool {
+  auto files = std::vector<std::string>();
+  for (auto it = args.begin() + 1; it != args.end(); ++it) {
+    if (*it == "--help") {
+      OutputHelp(args.at(0));
+      return false;
+    } else if (it->substr(0, 12) == "--threshold=") {
+      program_args.threshold = std::stod(it->substr(12));
+    } else if (it->substr(0, 9) == "--budget=") {
+      const std::string budget = it->substr(9);
+      auto pos = budget.rfind('=');
+      if (pos == std::string::npos) {
+        cerr << "Invalid budget: " << budget << endl;
+        return false;
+      }
+      program_args.budgets[budget.substr(0, pos)] = std::stod(budget.substr(pos + 1));
+    } else if (it->substr(0, 8) == "--alpha=") {
+      program_args.alpha = std::stod(it->substr(8));
+    } else if (it->substr(0, 2) == "--") {
+      cerr << "Warning: Unrecognized option " << *it << endl;
+    } else {
+      files.push_back(*it);
+    }
+  }
+
+  if (files.size() != 2) {
+    OutputHelp(args.at(0));
+    return false;
+  }
+  program_args.old_filename = files[0];
+  program_args.new_filename = files[1];
+  return true;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  if (!ReadArgs(std::vector<std::string>(argv, argv + argc))) {
+    return 2;
+  }
+
+  BenchmarkResults old_results;
+  BenchmarkResults new_results;
+  try {
+    old_results = ReadFile(program_args.old_filename);
+    new_results = ReadFile(program_args.new_filename);
+  } catch (std::runtime_error& ex_runtime) {
+    cerr << ex_runtime.what() << endl;
+    return 2;
+  }
+
+  CheckConditions(old_results, new_results);
+
+  // with too few samples even a consistent slowdown is never significant, which would pass every regression
+  bool is_underpowered = false;
+  for (auto&& n : new_results.benchmarks) {
+    auto o = std::find_if(old_results.benchmarks.begin(), old_results.benchmarks.end(),
+                          [&](const BenchmarkResult& r) { return r.name == n.name; });
+    if (o != old_results.benchmarks.end() &&
+        GetMinimumPValue(o->samples.size(), n.samples.size()) >= program_args.alpha) {
+      cerr << n.name << ": " << o->samples.size() << " and " << n.samples.size()
+           << " repetitions cannot detect a regression at alpha " << program_args.alpha << endl;
+      is_underpowered = true;
+    }
+  }
+  if (is_underpowered) {
+    const std::size_t required = GetRequiredRepetitions(program_args.alpha);
+    if (required != 0) {
+      cerr << "Run warframe_packages_bench with --repetitions=" << required << " or more." << endl;
+    }
+    return 2;
+  }
+
+  cout << std::left << std::setw(24) << "Benchmark" << std::right << std::setw(16) << "Old ns/op" << std::setw(16)
+       << "New ns/op" << std::setw(10) << "Change" << std::setw(10) << "Budget" << std::setw(10) << "p" << "  "
+       << "Verdict" << endl;
+
+  unsigned regression_count = 0;
+  for (auto&& n : new_results.benchmarks) {
+    auto o = std::find_if(old_results.benchmarks.begin(), old_results.benchmarks.end(),
+                          [&](const BenchmarkResult& r) { return r.name == n.name; });
+    if (o == old_results.benchmarks.end()) {
+      cout << std::left << std::setw(24) << n.name << std::right << std::setw(16) << "-" << std::setw(16) << std::fixed
+           << std::setprecision(0) << GetMedian(n.samples) << "  new" << endl;
+      continue;
+    }
+
+    const double old_median = GetMedian(o->samples);
+    const double new_median = GetMedian(n.samples);
+    const double change = old_median > 0.0 ? (new_median - old_median) / old_median * 100.0 : 0.0;
+    auto budget_it = program_args.budgets.find(n.name);
+    const double budget = budget_it != program_args.budgets.end() ? budget_it->second : program_args.threshold;
+
+    // test in the direction of the change, so that improvements are reported as confidently as regressions
+    const double p = change >= 0.0 ? GetPValue(o->samples, n.samples) : GetPValue(n.samples, o->samples);
+    std::string verdict = "ok";
+    if (p < program_args.alpha && change > budget) {
+      verdict = "REGRESSION";
+      ++regression_count;
+    } else if (p < program_args.alpha && change < -budget) {
+      verdict = "improved";
+    } else if (p >= program_args.alpha && std::fabs(change) > budget) {
+      verdict = "noisy";
+    }
+
+    cout << std::left << std::setw(24) << n.name << std::right << std::fixed << std::setprecision(0) << std::setw(16)
+         << old_median << std::setw(16) << new_median << std::setprecision(1) << std::setw(9) << std::showpos
+         << change << "%" << std::noshowpos << std::setw(9) << budget << "%" << std::setprecision(3) << std::setw(10)
+         << p << "  " << verdict << endl;
+  }
+  for (auto&& o : old_results.benchmarks) {
+    auto n = std::find_if(new_results.benchmarks.begin(), new_results.benchmarks.end(),
+                          [&](const BenchmarkResult& r) { return r.name == o.name; });
+    if (n == new_results.benchmarks.end()) {
+      cout << std::left << std::setw(24) << o.name << std::right << std::setw(16) << std::fixed << std::setprecision(0)
+           << GetMedian(o.samples) << std::setw(16) << "-" << "  removed" << endl;
+    }
+  }
+
+  if (regression_count != 0) {
+    cout << endl << regression_count << " benchmark(s) regressed beyond their budget." << endl;
+    return 1;
+  }
+  return 0;
+}
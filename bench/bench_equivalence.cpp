@@ -0,0 +1,421 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// This file checks that the sort, JSON and view paths produce exactly the output of their original implementations on
+// generated and real Packages files, and measures the speedup of each path over its original implementation.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "legacy_reference.h"
+#include "log.h"
+#include "package_generator.h"
+#include "packages.h"
+#include "timer.h"
+#include "util.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+namespace {
+/**
+ * @brief Maximum length of lines quoted when reporting a mismatch.
+ */
+constexpr std::size_t kMaxQuotedLength = 160;
+
+/**
+ * @brief List of program options.
+ */
+struct {
+  std::uint64_t size = 4 * 1024 * 1024;
+  std::uint64_t seed = 1;
+  std::string prettify_filename = BENCH_PRETTIFY_FILE;
+  std::string dir = ".";
+  unsigned header_count = 256;
+  unsigned repetitions = 3;
+  bool is_keep = false;
+  std::vector<std::string> filenames;
+} program_args;
+
+/**
+ * @brief A file to check the paths on.
+ */
+struct Corpus {
+  std::string name;
+  std::string filename;
+  bool is_generated;
+};
+
+/**
+ * @brief An output path with its original implementation.
+ */
+struct Check {
+  std::string name;
+  /**
+   * @brief Runs the original implementation, writing its output to the given stream.
+   */
+  std::function<void(std::ostream&)> legacy;
+  /**
+   * @brief Runs the current implementation, writing its output to the given stream.
+   */
+  std::function<void(std::ostream&)> current;
+
+  Check() = default;
+  Check(const Check&) = default;
+  Check(Check&&) = default;
+  auto operator=(const Check&) -> Check& = default;
+  auto operator=(Check&&) -> Check& = default;
+  ~Check();
+};
+
+Check::~Check() = default;
+
+/**
+ * @brief Stream buffer which discards all output.
+ */
+class NullBuffer : public std::streambuf {
+ protected:
+  auto overflow(int_type c) -> int_type override { return traits_type::not_eof(c); }
+  auto xsputn(const char*, std::streamsize n) -> std::streamsize override { return n; }
+};
+
+/**
+ * @brief Redirects everything written to stdout to another stream buffer while in scope.
+ */
+class RedirectStdout {
+ public:
+  explicit RedirectStdout(std::streambuf* buffer) : previous_(cout.rdbuf(buffer)) {}
+  RedirectStdout(RedirectStdout&&) = delete;
+  RedirectStdout(const RedirectStdout&) = delete;
+  auto operator=(RedirectStdout&&) noexcept -> RedirectStdout& = delete;
+  auto operator=(const RedirectStdout&) -> RedirectStdout& = delete;
+  ~RedirectStdout() { cout.rdbuf(previous_); }
+
+ private:
+  std::streambuf* previous_;
+};
+
+/**
+ * @brief Reads a whole file.
+ *
+ * @param filename Name of the file
+ * @return Contents of the file
+ */
+auto ReadWholeFile(const std::string& filename) -> std::string {
+  auto ifs = std::ifstream(filename, std::ios::binary);
+  std::ostringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+/**
+ * @brief Quotes a line of an output for a mismatch report.
+ *
+ * @param output Output containing the line
+ * @param begin Offset of the start of the line
+ * @return The line, truncated if it is too long
+ */
+auto QuoteLine(const std::string& output, std::size_t begin) -> std::string {
+  if (begin >= output.size()) {
+    return "(end of output)";
+  }
+
+  const std::size_t end = std::min(output.find('\n', begin), output.size());
+  std::string line = output.substr(begin, std::min(end - begin, kMaxQuotedLength));
+  if (end - begin > kMaxQuotedLength) {
+    line += "...";
+  }
+  return "\"" + line + "\"";
+}
+
+/**
+ * @brief Compares two outputs byte for byte.
+ *
+ * @param legacy Output of the original implementation
+ * @param current Output of the current implementation
+ * @return Description of the first difference, or an empty string if the outputs are identical
+ */
+auto CompareOutputs(const std::string& legacy, const std::string& current) -> std::string {
+  if (legacy == current) {
+    return "";
+  }
+
+  const auto mismatch = std::mismatch(legacy.begin(), legacy.begin() + static_cast<std::ptrdiff_t>(
+                                                          std::min(legacy.size(), current.size())),
+                                      current.begin());
+  const auto offset = static_cast<std::size_t>(mismatch.first - legacy.begin());
+  const auto line_begin = legacy.rfind('\n', offset == 0 ? 0 : offset - 1);
+  const std::size_t begin = line_begin == std::string::npos || offset == 0 ? 0 : line_begin + 1;
+  const auto line_number = std::count(legacy.begin(), legacy.begin() + static_cast<std::ptrdiff_t>(begin), '\n') + 1;
+
+  std::ostringstream ss;
+  ss << "first difference at byte " << offset << ", line " << line_number << " (" << legacy.size() << " vs "
+     << current.size() << " bytes)\n"
+     << "    legacy:  " << QuoteLine(legacy, begin) << "\n"
+     << "    current: " << QuoteLine(current, begin);
+  return ss.str();
+}
+
+/**
+ * @brief Runs an implementation repeatedly, keeping the output of the last run.
+ *
+ * @param run Implementation to run
+ * @param output Output of the last run
+ * @return Shortest time of all runs in milliseconds
+ */
+auto TimeRuns(const std::function<void(std::ostream&)>& run, std::string* const output) -> double {
+  double best = std::numeric_limits<double>::max();
+  for (unsigned i = 0; i < std::max(1u, program_args.repetitions); ++i) {
+    std::ostringstream ss;
+
+    Timer t;
+    t.Start();
+    run(ss);
+    t.Stop();
+
+    best = std::min(best, std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+    *output = ss.str();
+  }
+  return best;
+}
+
+/**
+ * @brief Samples headers evenly from all headers of a file.
+ *
+ * @param headers Headers of the file
+ * @return Names of the sampled headers
+ */
+auto SampleHeaders(const std::map<std::string, unsigned>& headers) -> std::vector<std::string> {
+  auto samples = std::vector<std::string>();
+  const std::size_t stride = headers.size() / std::max(1u, program_args.header_count) + 1;
+
+  std::size_t index = 0;
+  for (auto&& h : headers) {
+    if (index++ % stride == 0) {
+      samples.push_back(h.first);
+    }
+  }
+  return samples;
+}
+
+/**
+ * @brief Checks all paths on a file, and outputs a row for every path.
+ *
+ * @param corpus File to check
+ * @return Number of paths whose output differs from their original implementation
+ */
+auto CheckCorpus(const Corpus& corpus) -> unsigned {
+  const std::string outfile = program_args.dir + "/equivalence_output.tmp";
+
+  std::unique_ptr<Packages> packages;
+  {
+    NullBuffer null;
+    RedirectStdout redirect(&null);
+    std::string prettify_filename = program_args.prettify_filename;
+    packages = std::make_unique<Packages>(corpus.filename, std::ifstream(corpus.filename), std::move(prettify_filename));
+  }
+  const LegacyPrettifier legacy_prettifier(program_args.prettify_filename);
+  const auto headers = LegacyParseFile(corpus.filename);
+  const auto samples = SampleHeaders(headers);
+
+  const auto no_progress = std::numeric_limits<unsigned>::max();
+  auto checks = std::vector<Check>();
+
+  const auto sort_options = std::vector<std::pair<std::string, unsigned>>{
+      {"SortFile", 0},
+      {"SortFile --diff", static_cast<unsigned>(Packages::SortOptions::kDiff)},
+      {"SortFile --prettify", static_cast<unsigned>(Packages::SortOptions::kPrettify)},
+  };
+  for (auto&& o : sort_options) {
+    const unsigned opt_mask = o.second;
+    checks.push_back({o.first,
+                      [&, opt_mask](std::ostream& os) {
+                        LegacySortFile(corpus.filename, outfile, opt_mask, legacy_prettifier);
+                        os << ReadWholeFile(outfile);
+                      },
+                      [&, opt_mask](std::ostream& os) {
+                        packages->SortFile(outfile, opt_mask, no_progress);
+                        os << ReadWholeFile(outfile);
+                      }});
+  }
+  checks.push_back({"DumpJson",
+                    [&](std::ostream& os) {
+                      LegacyDumpJson(corpus.filename, outfile);
+                      os << ReadWholeFile(outfile);
+                    },
+                    [&](std::ostream& os) {
+                      packages->DumpJson(std::string(outfile), no_progress);
+                      os << ReadWholeFile(outfile);
+                    }});
+  for (bool is_raw : {true, false}) {
+    checks.push_back({is_raw ? "OutputHeader --raw" : "OutputHeader",
+                      [&, is_raw](std::ostream& os) {
+                        for (auto&& h : samples) {
+                          LegacyOutputHeader(corpus.filename, headers, h, is_raw, legacy_prettifier, os);
+                        }
+                      },
+                      [&, is_raw](std::ostream& os) {
+                        RedirectStdout redirect(os.rdbuf());
+                        for (auto&& h : samples) {
+                          packages->OutputHeader(h, is_raw);
+                        }
+                      }});
+  }
+
+  unsigned mismatch_count = 0;
+  for (auto&& c : checks) {
+    std::string legacy_output;
+    std::string current_output;
+    double legacy_ms;
+    double current_ms;
+    {
+      // the paths report their progress to stdout, which is not part of their output
+      NullBuffer null;
+      RedirectStdout redirect(&null);
+      legacy_ms = TimeRuns(c.legacy, &legacy_output);
+      current_ms = TimeRuns(c.current, &current_output);
+    }
+
+    const std::string difference = CompareOutputs(legacy_output, current_output);
+    if (!difference.empty()) {
+      ++mismatch_count;
+    }
+
+    cout << std::left << std::setw(16) << corpus.name << std::setw(22) << c.name << std::right << std::fixed
+         << std::setprecision(1) << std::setw(12) << legacy_ms << std::setw(12) << current_ms << std::setw(9)
+         << std::setprecision(2) << (current_ms > 0.0 ? legacy_ms / current_ms : 0.0) << "x"
+         << "  " << (difference.empty() ? "identical" : "MISMATCH") << endl;
+    if (!difference.empty()) {
+      cout << "  " << difference << endl;
+    }
+  }
+
+  std::remove(outfile.c_str());
+  return mismatch_count;
+}
+
+/**
+ * @brief Parse all arguments in the command line.
+ *
+ * @param args Vector of arguments
+ * @return True if the checks should run
+ */
+auto ReadArgs(const std::vector<std::string>& args) -> bool {
+  for (auto it = args.begin() + 1; it != args.end(); ++it) {
+    if (*it == "--help") {
+      cout << "Usage: " << args.at(0) << " [OPTION]... [FILE]...\n"
+           << "Checks the sort, JSON and view paths against their original implementations on generated files,\n"
+           << "and on each Packages [FILE].\n\n"
+           << "      --size=[SIZE]\tsize of each generated file, e.g. 4MB or 1GB (default: 4MB)\n"
+           << "      --seed=[N]\tseed of the first generated file (default: 1)\n"
+           << "      --headers=[N]\tnumber of headers to view in each file (default: 256)\n"
+           << "      --prettify=[FILE]\tprettify file used by both implementations (default: bundled file)\n"
+           << "      --repetitions=[N]\ttime the fastest of [N] runs of each path (default: 3)\n"
+           << "      --dir=[DIR]\twrite the generated files and outputs to [DIR] (default: .)\n"
+           << "      --keep\t\tkeep the generated files\n"
+           << "      --help\t\tdisplay this help and exit\n\n"
+           << "Exits with status 1 if any output differs, or 2 if a file cannot be read." << endl;
+      return false;
+    } else if (it->substr(0, 7) == "--size=") {
+      if (!ParseSize(it->substr(7), &program_args.size)) {
+        cerr << "Invalid size: " << it->substr(7) << endl;
+        exit(2);
+      }
+    } else if (it->substr(0, 7) == "--seed=") {
+      program_args.seed = std::stoull(it->substr(7));
+    } else if (it->substr(0, 10) == "--headers=") {
+      program_args.header_count = static_cast<unsigned>(std::stoul(it->substr(10)));
+    } else if (it->substr(0, 11) == "--prettify=") {
+      program_args.prettify_filename = it->substr(11);
+    } else if (it->substr(0, 14) == "--repetitions=") {
+      program_args.repetitions = static_cast<unsigned>(std::stoul(it->substr(14)));
+    } else if (it->substr(0, 6) == "--dir=") {
+      program_args.dir = it->substr(6);
+    } else if (*it == "--keep") {
+      program_args.is_keep = true;
+    } else if (it->substr(0, 2) == "--") {
+      cerr << "Warning: Unrecognized option " << *it << endl;
+    } else {
+      program_args.filenames.push_back(*it);
+    }
+  }
+  return true;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  if (!ReadArgs(std::vector<std::string>(argv, argv + argc))) {
+    return 0;
+  }
+
+  Log::Init();
+  Log::Disable();
+  SetClearScreenEnabled(false);
+
+  // generated files cover both line endings, and deeper and less regular packages than the defaults
+  auto variants = std::vector<std::pair<std::string, GeneratorOptions>>(3);
+  variants[0].first = "generated-crlf";
+  variants[1].first = "generated-lf";
+  variants[1].second.is_crlf = false;
+  variants[2].first = "generated-deep";
+  variants[2].second.max_depth = 8;
+  variants[2].second.mean_fields = 24;
+  variants[2].second.unparseable_percent = 10;
+
+  auto corpora = std::vector<Corpus>();
+  for (std::size_t i = 0; i < variants.size(); ++i) {
+    GeneratorOptions& options = variants[i].second;
+    options.size = program_args.size;
+    options.seed = program_args.seed + i;
+
+    const std::string filename = program_args.dir + "/equivalence_" + variants[i].first + ".txt";
+    auto ofs = std::ofstream(filename, std::ios::binary);
+    if (!ofs) {
+      cerr << filename << ": Cannot open file." << endl;
+      return 2;
+    }
+    GeneratePackages(ofs, options);
+    corpora.push_back({variants[i].first, filename, true});
+  }
+  for (auto&& f : program_args.filenames) {
+    if (!std::ifstream(f)) {
+      cerr << f << ": Cannot open file." << endl;
+      return 2;
+    }
+    corpora.push_back({f.substr(f.find_last_of("/\\") + 1), f, false});
+  }
+
+  cout << std::left << std::setw(16) << "Corpus" << std::setw(22) << "Path" << std::right << std::setw(12)
+       << "Legacy ms" << std::setw(12) << "Current ms" << std::setw(10) << "Speedup" << "  Output" << endl;
+
+  unsigned mismatch_count = 0;
+  for (auto&& c : corpora) {
+    mismatch_count += CheckCorpus(c);
+
+    if (c.is_generated && !program_args.is_keep) {
+      std::remove(c.filename.c_str());
+    }
+  }
+
+  if (mismatch_count != 0) {
+    cout << mismatch_count << " path(s) differ from their original implementation." << endl;
+    return 1;
+  }
+  cout << "All paths produce identical output." << endl;
+  return 0;
+}
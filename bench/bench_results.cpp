@@ -0,0 +1,487 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for reading and writing benchmark results.
+//
+
+#include "bench_results.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "init.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif  // !defined(_WIN32)
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE ""
+#endif  // BENCH_BUILD_TYPE
+
+namespace {
+/**
+ * @brief Parsed JSON value.
+ */
+struct JsonValue {
+  enum struct Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  JsonValue();
+  JsonValue(const JsonValue&);
+  JsonValue(JsonValue&&) noexcept;
+  auto operator=(const JsonValue&) -> JsonValue&;
+  auto operator=(JsonValue&&) noexcept -> JsonValue&;
+  ~JsonValue();
+
+  Type type = Type::kNull;
+  bool boolean = false;
+  double number = 0.0;
+  std::string string;
+  std::vector<JsonValue> array;
+  std::map<std::string, JsonValue> object;
+
+  /**
+   * @brief Finds a member of an object.
+   *
+   * @param key Name of the member
+   * @return Member
+   *
+   * @throw @c std::runtime_error if this is not an object, or has no such member
+   */
+  auto At(const std::string& key) const -> const JsonValue& {
+    if (type != Type::kObject) {
+      throw std::runtime_error("Expected an object containing \"" + key + "\"");
+    }
+    auto it = object.find(key);
+    if (it == object.end()) {
+      throw std::runtime_error("Missing \"" + key + "\"");
+    }
+    return it->second;
+  }
+
+  auto AsNumber() const -> double {
+    if (type != Type::kNumber) {
+      throw std::runtime_error("Expected a number");
+    }
+    return number;
+  }
+
+  auto AsUnsigned() const -> std::uint64_t { return static_cast<std::uint64_t>(AsNumber()); }
+
+  auto AsString() const -> const std::string& {
+    if (type != Type::kString) {
+      throw std::runtime_error("Expected a string");
+    }
+    return string;
+  }
+
+  auto AsArray() const -> const std::vector<JsonValue>& {
+    if (type != Type::kArray) {
+      throw std::runtime_error("Expected an array");
+    }
+    return array;
+  }
+};
+
+JsonValue::JsonValue() = default;
+JsonValue::JsonValue(const JsonValue&) = default;
+JsonValue::JsonValue(JsonValue&&) noexcept = default;
+auto JsonValue::operator=(const JsonValue&) -> JsonValue& = default;
+auto JsonValue::operator=(JsonValue&&) noexcept -> JsonValue& = default;
+JsonValue::~JsonValue() = default;
+
+/**
+ * @brief Recursive-descent parser for JSON documents.
+ */
+class JsonParser {
+ public:
+  explicit JsonParser(std::string text) : text_(std::move(text)) {}
+
+  /**
+   * @brief Parses the whole document.
+   *
+   * @return Root value
+   *
+   * @throw @c std::runtime_error if the document is not valid JSON
+   */
+  auto Parse() -> JsonValue {
+    JsonValue value = ParseValue();
+    SkipWhitespace();
+    if (pos_ != text_.size()) {
+      Fail("Unexpected trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  [[noreturn]] void Fail(const std::string& message) const {
+    throw std::runtime_error(message + " at offset " + std::to_string(pos_));
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      ++pos_;
+    }
+  }
+
+  auto Consume(char c) -> bool {
+    SkipWhitespace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void Expect(char c) {
+    if (!Consume(c)) {
+      Fail(std::string("Expected '") + c + "'");
+    }
+  }
+
+  auto ConsumeLiteral(const std::string& literal) -> bool {
+    if (text_.compare(pos_, literal.size(), literal) == 0) {
+      pos_ += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  auto ParseValue() -> JsonValue {
+    SkipWhitespace();
+    if (pos_ == text_.size()) {
+      Fail("Unexpected end of document");
+    }
+
+    JsonValue value;
+    const char c = text_[pos_];
+    if (c == '{') {
+      value.type = JsonValue::Type::kObject;
+      ++pos_;
+      if (!Consume('}')) {
+        do {
+          SkipWhitespace();
+          std::string key = ParseString();
+          Expect(':');
+          value.object[key] = ParseValue();
+        } while (Consume(','));
+        Expect('}');
+      }
+    } else if (c == '[') {
+      value.type = JsonValue::Type::kArray;
+      ++pos_;
+      if (!Consume(']')) {
+        do {
+          value.array.push_back(ParseValue());
+        } while (Consume(','));
+        Expect(']');
+      }
+    } else if (c == '"') {
+      value.type = JsonValue::Type::kString;
+      value.string = ParseString();
+    } else if (ConsumeLiteral("true")) {
+      value.type = JsonValue::Type::kBool;
+      value.boolean = true;
+    } else if (ConsumeLiteral("false")) {
+      value.type = JsonValue::Type::kBool;
+    } else if (ConsumeLiteral("null")) {
+      value.type = JsonValue::Type::kNull;
+    } else {
+      value.type = JsonValue::Type::kNumber;
+      const char* begin = text_.c_str() + pos_;
+      char* end = nullptr;
+      value.number = std::strtod(begin, &end);
+      if (end == begin) {
+        Fail("Unexpected character");
+      }
+      pos_ += static_cast<std::size_t>(end - begin);
+    }
+    return value;
+  }
+
+  auto ParseString() -> std::string {
+    if (pos_ == text_.size() || text_[pos_] != '"') {
+      Fail("Expected a string");
+    }
+    ++pos_;
+
+    std::string s;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\' && pos_ < text_.size()) {
+        c = text_[pos_++];
+        switch (c) {
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case 'u':
+            // non-ASCII characters are never written, so they are only kept as placeholders
+            pos_ = std::min(pos_ + 4, text_.size());
+            c = '?';
+            break;
+          default:
+            break;
+        }
+      }
+      s.push_back(c);
+    }
+    if (pos_ == text_.size()) {
+      Fail("Unterminated string");
+    }
+    ++pos_;
+    return s;
+  }
+
+  std::string text_;
+  std::size_t pos_ = 0;
+};
+
+/**
+ * @brief Escapes a string to be used in a JSON string.
+ *
+ * @param s String to escape
+ * @return Escaped string
+ */
+auto EscapeJson(const std::string& s) -> std::string {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (c == '\n') {
+      out += "\\n";
+    } else if (c == '\t') {
+      out += "\\t";
+    } else if (static_cast<unsigned char>(c) >= 0x20) {
+      out.push_back(c);
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Reads the model name of the CPU.
+ *
+ * @return Model name, or "unknown" if it cannot be determined
+ */
+auto GetCpuName() -> std::string {
+  auto ifs = std::ifstream("/proc/cpuinfo");
+  std::string line;
+  while (getline(ifs, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      auto pos = line.find(':');
+      if (pos != std::string::npos) {
+        return line.substr(line.find_first_not_of(' ', pos + 1));
+      }
+    }
+  }
+  return "unknown";
+}
+
+/**
+ * @return Name of the compiler which built this program
+ */
+auto GetCompilerName() -> std::string {
+#if defined(__clang__)
+  return "Clang " __clang_version__;
+#elif defined(__GNUC__)
+  return "GCC " __VERSION__;
+#elif defined(_MSC_VER)
+  return "MSVC " + std::to_string(_MSC_VER);
+#else
+  return "unknown";
+#endif
+}
+}  // namespace
+
+BenchmarkEnvironment::BenchmarkEnvironment() = default;
+BenchmarkEnvironment::BenchmarkEnvironment(const BenchmarkEnvironment&) = default;
+BenchmarkEnvironment::BenchmarkEnvironment(BenchmarkEnvironment&&) noexcept = default;
+auto BenchmarkEnvironment::operator=(const BenchmarkEnvironment&) -> BenchmarkEnvironment& = default;
+auto BenchmarkEnvironment::operator=(BenchmarkEnvironment&&) noexcept -> BenchmarkEnvironment& = default;
+BenchmarkEnvironment::~BenchmarkEnvironment() = default;
+
+BenchmarkResults::BenchmarkResults() = default;
+BenchmarkResults::BenchmarkResults(const BenchmarkResults&) = default;
+BenchmarkResults::BenchmarkResults(BenchmarkResults&&) noexcept = default;
+auto BenchmarkResults::operator=(const BenchmarkResults&) -> BenchmarkResults& = default;
+auto BenchmarkResults::operator=(BenchmarkResults&&) noexcept -> BenchmarkResults& = default;
+BenchmarkResults::~BenchmarkResults() = default;
+
+auto GetEnvironment() -> BenchmarkEnvironment {
+  BenchmarkEnvironment env;
+
+  const std::time_t now = std::time(nullptr);
+  char date[32] = "";
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  env.date = date;
+
+#if !defined(_WIN32)
+  char host[256] = "";
+  if (gethostname(host, sizeof(host) - 1) == 0) {
+    env.host = host;
+  }
+#endif  // !defined(_WIN32)
+
+  env.cpu = GetCpuName();
+  env.cpu_count = std::thread::hardware_concurrency();
+  env.compiler = GetCompilerName();
+  env.build_type = BENCH_BUILD_TYPE;
+  env.version = kBuildString;
+  return env;
+}
+
+auto GetMedian(std::vector<double> values) -> double {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  std::sort(values.begin(), values.end());
+  const std::size_t mid = values.size() / 2;
+  return values.size() % 2 == 0 ? (values[mid - 1] + values[mid]) / 2.0 : values[mid];
+}
+
+auto GetMean(const std::vector<double>& values) -> double {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  double sum = 0.0;
+  for (auto v : values) {
+    sum += v;
+  }
+  return sum / static_cast<double>(values.size());
+}
+
+auto GetStddev(const std::vector<double>& values) -> double {
+  if (values.size() < 2) {
+    return 0.0;
+  }
+
+  const double mean = GetMean(values);
+  double sum = 0.0;
+  for (auto v : values) {
+    sum += (v - mean) * (v - mean);
+  }
+  return std::sqrt(sum / static_cast<double>(values.size() - 1));
+}
+
+void WriteResults(std::ostream& os, const BenchmarkResults& results) {
+  const auto& env = results.environment;
+  const auto& input = results.input;
+
+  std::ostringstream ss;
+  ss << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+  ss << "{\n";
+  ss << "  \"version\": " << kResultsVersion << ",\n";
+  ss << "  \"environment\": {\n";
+  ss << "    \"date\": \"" << EscapeJson(env.date) << "\",\n";
+  ss << "    \"host\": \"" << EscapeJson(env.host) << "\",\n";
+  ss << "    \"cpu\": \"" << EscapeJson(env.cpu) << "\",\n";
+  ss << "    \"cpu_count\": " << env.cpu_count << ",\n";
+  ss << "    \"compiler\": \"" << EscapeJson(env.compiler) << "\",\n";
+  ss << "    \"build_type\": \"" << EscapeJson(env.build_type) << "\",\n";
+  ss << "    \"version\": \"" << EscapeJson(env.version) << "\"\n";
+  ss << "  },\n";
+  ss << "  \"input\": {\n";
+  ss << "    \"size\": " << input.size << ",\n";
+  ss << "    \"seed\": " << input.seed << ",\n";
+  ss << "    \"bytes\": " << input.bytes << ",\n";
+  ss << "    \"lines\": " << input.lines << ",\n";
+  ss << "    \"headers\": " << input.headers << ",\n";
+  ss << "    \"max_depth\": " << input.max_depth << "\n";
+  ss << "  },\n";
+  ss << "  \"benchmarks\": [";
+  for (std::size_t i = 0; i < results.benchmarks.size(); ++i) {
+    const auto& b = results.benchmarks[i];
+    const double median = GetMedian(b.samples);
+    const double ops_per_second = median > 0.0 ? 1e9 / median : 0.0;
+
+    ss << (i == 0 ? "\n" : ",\n");
+    ss << "    {\n";
+    ss << "      \"name\": \"" << EscapeJson(b.name) << "\",\n";
+    ss << "      \"bytes_per_op\": " << b.bytes_per_op << ",\n";
+    ss << "      \"repetitions\": " << b.samples.size() << ",\n";
+    ss << "      \"median_ns_per_op\": " << median << ",\n";
+    ss << "      \"mean_ns_per_op\": " << GetMean(b.samples) << ",\n";
+    ss << "      \"stddev_ns_per_op\": " << GetStddev(b.samples) << ",\n";
+    ss << "      \"min_ns_per_op\": " << (b.samples.empty() ? 0.0 : *std::min_element(b.samples.begin(), b.samples.end()))
+       << ",\n";
+    ss << "      \"max_ns_per_op\": " << (b.samples.empty() ? 0.0 : *std::max_element(b.samples.begin(), b.samples.end()))
+       << ",\n";
+    ss << "      \"ops_per_second\": " << ops_per_second << ",\n";
+    ss << "      \"mb_per_second\": " << static_cast<double>(b.bytes_per_op) * ops_per_second / (1024.0 * 1024.0)
+       << ",\n";
+    ss << "      \"samples_ns_per_op\": [";
+    for (std::size_t j = 0; j < b.samples.size(); ++j) {
+      ss << (j == 0 ? "" : ", ") << b.samples[j];
+    }
+    ss << "]\n";
+    ss << "    }";
+  }
+  ss << "\n  ]\n";
+  ss << "}\n";
+
+  os << ss.str();
+}
+
+auto ReadResults(std::istream& is) -> BenchmarkResults {
+  std::ostringstream text;
+  text << is.rdbuf();
+  const JsonValue root = JsonParser(text.str()).Parse();
+
+  if (root.At("version").AsNumber() > kResultsVersion) {
+    throw std::runtime_error("Unsupported results version");
+  }
+
+  BenchmarkResults results;
+
+  const JsonValue& env = root.At("environment");
+  results.environment.date = env.At("date").AsString();
+  results.environment.host = env.At("host").AsString();
+  results.environment.cpu = env.At("cpu").AsString();
+  results.environment.cpu_count = static_cast<unsigned>(env.At("cpu_count").AsUnsigned());
+  results.environment.compiler = env.At("compiler").AsString();
+  results.environment.build_type = env.At("build_type").AsString();
+  results.environment.version = env.At("version").AsString();
+
+  const JsonValue& input = root.At("input");
+  results.input.size = input.At("size").AsUnsigned();
+  results.input.seed = input.At("seed").AsUnsigned();
+  results.input.bytes = input.At("bytes").AsUnsigned();
+  results.input.lines = input.At("lines").AsUnsigned();
+  results.input.headers = input.At("headers").AsUnsigned();
+  results.input.max_depth = static_cast<unsigned>(input.At("max_depth").AsUnsigned());
+
+  for (auto&& b : root.At("benchmarks").AsArray()) {
+    BenchmarkResult result;
+    result.name = b.At("name").AsString();
+    result.bytes_per_op = b.At("bytes_per_op").AsUnsigned();
+    for (auto&& s : b.At("samples_ns_per_op").AsArray()) {
+      result.samples.push_back(s.AsNumber());
+    }
+    results.benchmarks.push_back(std::move(result));
+  }
+
+  return results;
+}
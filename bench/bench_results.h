@@ -0,0 +1,127 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for reading and writing benchmark results.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_BENCH_BENCH_RESULTS_H_
+#define WARFRAME_PACKAGES_DEPARSER_BENCH_BENCH_RESULTS_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Version of the results format. Incremented whenever a field changes meaning.
+ */
+constexpr int kResultsVersion = 1;
+
+/**
+ * @brief Machine and build which produced a set of results.
+ */
+struct BenchmarkEnvironment {
+  BenchmarkEnvironment();
+  BenchmarkEnvironment(const BenchmarkEnvironment&);
+  BenchmarkEnvironment(BenchmarkEnvironment&&) noexcept;
+  auto operator=(const BenchmarkEnvironment&) -> BenchmarkEnvironment&;
+  auto operator=(BenchmarkEnvironment&&) noexcept -> BenchmarkEnvironment&;
+  ~BenchmarkEnvironment();
+
+  std::string date;
+  std::string host;
+  std::string cpu;
+  unsigned cpu_count = 0;
+  std::string compiler;
+  std::string build_type;
+  std::string version;
+};
+
+/**
+ * @brief Generated input which a set of results was measured on.
+ */
+struct BenchmarkInput {
+  std::uint64_t size = 0;
+  std::uint64_t seed = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t lines = 0;
+  std::uint64_t headers = 0;
+  unsigned max_depth = 0;
+};
+
+/**
+ * @brief Results of a single benchmark.
+ */
+struct BenchmarkResult {
+  std::string name;
+  /**
+   * @brief Bytes processed by each operation on average.
+   */
+  std::uint64_t bytes_per_op = 0;
+  /**
+   * @brief Time per operation of each repetition, in nanoseconds.
+   */
+  std::vector<double> samples;
+};
+
+/**
+ * @brief Results of a benchmark run.
+ */
+struct BenchmarkResults {
+  BenchmarkResults();
+  BenchmarkResults(const BenchmarkResults&);
+  BenchmarkResults(BenchmarkResults&&) noexcept;
+  auto operator=(const BenchmarkResults&) -> BenchmarkResults&;
+  auto operator=(BenchmarkResults&&) noexcept -> BenchmarkResults&;
+  ~BenchmarkResults();
+
+  BenchmarkEnvironment environment;
+  BenchmarkInput input;
+  std::vector<BenchmarkResult> benchmarks;
+};
+
+/**
+ * Describes the machine and build of the current process.
+ *
+ * @return Environment of the current process
+ */
+auto GetEnvironment() -> BenchmarkEnvironment;
+
+/**
+ * @param values Samples
+ * @return Median of the samples, or 0 if there are none
+ */
+auto GetMedian(std::vector<double> values) -> double;
+/**
+ * @param values Samples
+ * @return Mean of the samples, or 0 if there are none
+ */
+auto GetMean(const std::vector<double>& values) -> double;
+/**
+ * @param values Samples
+ * @return Sample standard deviation of the samples, or 0 if there are fewer than two
+ */
+auto GetStddev(const std::vector<double>& values) -> double;
+
+/**
+ * Writes results as JSON.
+ *
+ * Besides the samples, each benchmark also includes their median, mean, standard deviation and range, and the median
+ * throughput in operations and megabytes per second.
+ *
+ * @param os Stream to output to
+ * @param results Results to write
+ */
+void WriteResults(std::ostream& os, const BenchmarkResults& results);
+/**
+ * Reads results written by @c WriteResults.
+ *
+ * @param is Stream to read from
+ * @return Results
+ *
+ * @throw @c std::runtime_error if the stream is not valid JSON, or is not in the results format
+ */
+auto ReadResults(std::istream& is) -> BenchmarkResults;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_BENCH_BENCH_RESULTS_H_
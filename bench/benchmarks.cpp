@@ -0,0 +1,420 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// This file runs microbenchmarks of the main operations on a synthetic Packages file.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "bench_results.h"
+#include "log.h"
+#include "package_generator.h"
+#include "packages.h"
+#include "prettify.h"
+#include "profiler.h"
+#include "timer.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+namespace {
+/**
+ * @brief Maximum number of headers sampled for benchmarks which operate on single headers.
+ */
+constexpr std::size_t kSampleHeaderCount = 1024;
+/**
+ * @brief Maximum number of lines sampled for benchmarks which operate on single lines.
+ */
+constexpr std::size_t kSampleLineCount = 65536;
+
+/**
+ * @brief List of program options.
+ */
+struct {
+  GeneratorOptions generator;
+  std::string dir = ".";
+  std::string filter = "";
+  std::string json_filename = "";
+  double min_seconds = 0.5;
+  unsigned repetitions = 5;
+  bool is_keep = false;
+} program_args;
+
+/**
+ * @brief Result of a single repetition of a benchmark.
+ */
+struct Result {
+  std::uint64_t ops = 0;
+  std::uint64_t bytes = 0;
+  double seconds = 0.0;
+};
+
+/**
+ * @brief Header sampled from the generated file.
+ */
+struct SampleHeader {
+  std::string name;
+  /**
+   * @brief Size of the header in bytes, including the header line.
+   */
+  std::uint64_t bytes;
+};
+
+/**
+ * @brief Data sampled from the generated file.
+ */
+struct Samples {
+  std::uint64_t file_bytes = 0;
+  /**
+   * @brief Total size of all header names in bytes.
+   */
+  std::uint64_t header_name_bytes = 0;
+  std::vector<SampleHeader> headers;
+  std::vector<std::string> lines;
+};
+
+/**
+ * @brief Stream buffer which discards all output.
+ */
+class NullBuffer : public std::streambuf {
+ protected:
+  auto overflow(int_type c) -> int_type override { return traits_type::not_eof(c); }
+  auto xsputn(const char*, std::streamsize n) -> std::streamsize override { return n; }
+};
+
+/**
+ * @brief Discards everything written to stdout while in scope, as operations report their progress there.
+ */
+class SilenceStdout {
+ public:
+  SilenceStdout() : previous_(cout.rdbuf(&buffer_)) {}
+  SilenceStdout(SilenceStdout&&) = delete;
+  SilenceStdout(const SilenceStdout&) = delete;
+  auto operator=(SilenceStdout&&) noexcept -> SilenceStdout& = delete;
+  auto operator=(const SilenceStdout&) -> SilenceStdout& = delete;
+  ~SilenceStdout() { cout.rdbuf(previous_); }
+
+ private:
+  NullBuffer buffer_;
+  std::streambuf* previous_;
+};
+
+/**
+ * @brief Reads the generated file, sampling headers evenly and keeping the first lines.
+ *
+ * @param filename Name of the generated file
+ * @param header_count Number of headers in the file
+ * @return Sampled data
+ */
+auto SampleFile(const std::string& filename, std::uint64_t header_count) -> Samples {
+  Samples samples;
+  const std::uint64_t stride = header_count / kSampleHeaderCount + 1;
+
+  auto ifs = std::ifstream(filename);
+  std::string line;
+  std::uint64_t header_index = 0;
+  bool is_sampling = false;
+  while (getline(ifs, line)) {
+    samples.file_bytes += line.size() + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    auto pos = line.find("FullPackageName=");
+    if (pos != std::string::npos) {
+      const std::string name = line.substr(pos + 16);
+      samples.header_name_bytes += name.size();
+      is_sampling = header_index++ % stride == 0;
+      if (is_sampling) {
+        samples.headers.push_back({name, 0});
+      }
+    }
+    if (is_sampling) {
+      samples.headers.back().bytes += line.size() + 1;
+    }
+
+    if (samples.lines.size() < kSampleLineCount && !line.empty()) {
+      samples.lines.push_back(line);
+    }
+  }
+
+  return samples;
+}
+
+/**
+ * @brief Runs an operation repeatedly until the minimum time has passed, and times it by the wall clock.
+ *
+ * @param op Operation to run, given the number of the run and returning the number of bytes it processed
+ * @return Result of the benchmark
+ */
+auto RunTimed(const std::function<std::uint64_t(std::uint64_t)>& op) -> Result {
+  Result r;
+
+  Timer t;
+  t.Start();
+  do {
+    r.bytes += op(r.ops);
+    ++r.ops;
+  } while (std::chrono::duration_cast<Timer::seconds>(t.GetRawElapsedTime()).count() < program_args.min_seconds);
+  t.Stop();
+
+  r.seconds = std::chrono::duration_cast<Timer::seconds>(t.GetRawTime()).count();
+  return r;
+}
+
+/**
+ * @brief Runs an operation repeatedly until the minimum time has passed, and times it by its profiled zones.
+ *
+ * This measures operations which cannot be invoked on their own, such as the private stages of @c Packages.
+ *
+ * @param zone Name of the profiled zone
+ * @param op Operation to run, given the number of the run and returning the number of bytes processed in the zone
+ * @return Result of the benchmark
+ */
+auto RunZone(const std::string& zone, const std::function<std::uint64_t(std::uint64_t)>& op) -> Result {
+  const Profiler::ZoneTotals before = Profiler::GetZoneTotals(zone);
+
+  Profiler::SetRecording(true);
+  Result r = RunTimed(op);
+  Profiler::SetRecording(false);
+
+  const Profiler::ZoneTotals after = Profiler::GetZoneTotals(zone);
+  r.ops = after.count - before.count;
+  r.seconds = static_cast<double>(after.total_ns - before.total_ns) / 1e9;
+  return r;
+}
+
+/**
+ * @brief Runs all repetitions of a benchmark.
+ *
+ * @param name Name of the benchmark
+ * @param run Function running a single repetition
+ * @return Results of all repetitions
+ */
+auto RunRepetitions(const std::string& name, const std::function<Result()>& run) -> BenchmarkResult {
+  BenchmarkResult result;
+  result.name = name;
+
+  std::uint64_t ops = 0;
+  std::uint64_t bytes = 0;
+  for (unsigned i = 0; i < program_args.repetitions; ++i) {
+    Result r;
+    {
+      SilenceStdout silence;
+      r = run();
+    }
+    if (r.ops != 0) {
+      result.samples.push_back(r.seconds * 1e9 / static_cast<double>(r.ops));
+    }
+    ops += r.ops;
+    bytes += r.bytes;
+  }
+  result.bytes_per_op = ops == 0 ? 0 : bytes / ops;
+
+  return result;
+}
+
+/**
+ * @brief Outputs the results of a benchmark.
+ *
+ * @param result Results to output
+ */
+void OutputResult(const BenchmarkResult& result) {
+  const double median = GetMedian(result.samples);
+  const double mean = GetMean(result.samples);
+  const double ops_per_second = median > 0.0 ? 1e9 / median : 0.0;
+  const double mb_per_second = static_cast<double>(result.bytes_per_op) * ops_per_second / (1024.0 * 1024.0);
+  const double deviation = mean > 0.0 ? GetStddev(result.samples) / mean * 100.0 : 0.0;
+
+  cout << std::left << std::setw(24) << result.name << std::right << std::fixed << std::setw(8)
+       << result.samples.size() << std::setw(16) << std::setprecision(0) << median << std::setw(16)
+       << std::setprecision(1) << ops_per_second << std::setw(12) << mb_per_second << std::setw(10) << deviation
+       << endl;
+}
+
+/**
+ * @brief Parse all arguments in the command line.
+ *
+ * @param args Vector of arguments
+ * @return True if the benchmarks should run
+ */
+auto ReadArgs(const std::vector<std::string>& args) -> bool {
+  for (auto it = args.begin() + 1; it != args.end(); ++it) {
+    if (*it == "--help") {
+      cout << "Usage: " << args.at(0) << " [OPTION]...\n"
+           << "      --size=[SIZE]\tsize of the generated file, e.g. 10MB or 10GB (default: 10MB)\n"
+           << "      --seed=[N]\tseed of the generator (default: 1)\n"
+           << "      --dir=[DIR]\twrite the generated file and outputs to [DIR] (default: .)\n"
+           << "      --filter=[STR]\tonly run benchmarks whose name contains [STR]\n"
+           << "      --min-time=[S]\trun each repetition for at least [S] seconds (default: 0.5)\n"
+           << "      --repetitions=[N]\trepeat each benchmark [N] times (default: 5)\n"
+           << "      --json=[FILE]\twrite the results to [FILE] as JSON, to be compared with bench_compare\n"
+           << "      --keep\t\tkeep the generated file and outputs\n"
+           << "      --help\t\tdisplay this help and exit\n"
+           << endl;
+      return false;
+    } else if (it->substr(0, 7) == "--size=") {
+      if (!ParseSize(it->substr(7), &program_args.generator.size)) {
+        cerr << "Invalid size: " << it->substr(7) << endl;
+        return false;
+      }
+    } else if (it->substr(0, 7) == "--seed=") {
+      program_args.generator.seed = std::stoull(it->substr(7));
+    } else if (it->substr(0, 6) == "--dir=") {
+      program_args.dir = it->substr(6);
+    } else if (it->substr(0, 9) == "--filter=") {
+      program_args.filter = it->substr(9);
+    } else if (it->substr(0, 11) == "--min-time=") {
+      program_args.min_seconds = std::stod(it->substr(11));
+    } else if (it->substr(0, 14) == "--repetitions=") {
+      program_args.repetitions = static_cast<unsigned>(std::stoul(it->substr(14)));
+    } else if (it->substr(0, 7) == "--json=") {
+      program_args.json_filename = it->substr(7);
+    } else if (*it == "--keep") {
+      program_args.is_keep = true;
+    } else {
+      cerr << "Warning: Unrecognized option " << *it << endl;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  if (!ReadArgs(std::vector<std::string>(argv, argv + argc))) {
+    return 0;
+  }
+
+  Log::Init();
+  Log::Disable();
+
+  const std::string filename = program_args.dir + "/bench_packages.txt";
+  const std::string sorted_filename = program_args.dir + "/bench_sorted.txt";
+  const std::string json_filename = program_args.dir + "/bench_dump.json";
+
+  cerr << "Generating " << filename << "..." << endl;
+  GeneratorSummary summary;
+  {
+    auto ofs = std::ofstream(filename, std::ios::binary);
+    if (!ofs) {
+      cerr << filename << ": Cannot open file." << endl;
+      return 1;
+    }
+    summary = GeneratePackages(ofs, program_args.generator);
+  }
+  cerr << "Generated " << summary.bytes << " bytes, " << summary.lines << " lines, " << summary.headers
+       << " headers, maximum depth " << summary.max_depth << endl;
+
+  const Samples samples = SampleFile(filename, summary.headers);
+
+  std::unique_ptr<Packages> packages;
+  {
+    SilenceStdout silence;
+    packages = std::make_unique<Packages>(filename, std::ifstream(filename));
+  }
+  const auto prettifier = packages->GetPrettifier();
+
+  const auto benchmarks = std::vector<std::pair<std::string, std::function<Result()>>>{
+      {"ParseFile",
+       [&] {
+         return RunZone("Packages::ParseFile", [&](std::uint64_t) {
+           Packages p(filename, std::ifstream(filename));
+           return samples.file_bytes;
+         });
+       }},
+      {"Find",
+       [&] {
+         return RunTimed([&](std::uint64_t i) {
+           const std::string& name = samples.headers[i % samples.headers.size()].name;
+           packages->Find(name.substr(name.rfind('/') + 1), false, std::numeric_limits<unsigned>::max());
+           return samples.header_name_bytes;
+         });
+       }},
+      {"GetHeaderContents",
+       [&] {
+         return RunZone("Packages::GetHeaderContents", [&](std::uint64_t i) {
+           const SampleHeader& h = samples.headers[i % samples.headers.size()];
+           packages->HeaderToJson(h.name, Packages::StructureOptions::kNone, {});
+           return h.bytes;
+         });
+       }},
+      {"HeaderToJson",
+       [&] {
+         return RunZone("Packages::HeaderToJson", [&](std::uint64_t i) {
+           const SampleHeader& h = samples.headers[i % samples.headers.size()];
+           packages->HeaderToJson(h.name, Packages::StructureOptions::kNone, {});
+           return h.bytes;
+         });
+       }},
+      {"PrettifyLine",
+       [&] {
+         return RunTimed([&](std::uint64_t) {
+           std::uint64_t bytes = 0;
+           for (auto&& l : samples.lines) {
+             std::string line = l;
+             prettifier->PrettifyLine(line);
+             bytes += l.size();
+           }
+           return bytes;
+         });
+       }},
+      {"SortFile",
+       [&] {
+         return RunTimed([&](std::uint64_t) {
+           packages->SortFile(sorted_filename, static_cast<unsigned>(Packages::SortOptions::kPrettify),
+                              std::numeric_limits<unsigned>::max());
+           return samples.file_bytes;
+         });
+       }},
+      {"DumpJson",
+       [&] {
+         return RunTimed([&](std::uint64_t) {
+           packages->DumpJson(std::string(json_filename), std::numeric_limits<unsigned>::max());
+           return samples.file_bytes;
+         });
+       }}};
+
+  BenchmarkResults results;
+  results.environment = GetEnvironment();
+  results.input = {program_args.generator.size, program_args.generator.seed, summary.bytes,
+                   summary.lines,               summary.headers,             summary.max_depth};
+
+  cout << std::left << std::setw(24) << "Benchmark" << std::right << std::setw(8) << "Reps" << std::setw(16)
+       << "Median ns/op" << std::setw(16) << "ops/s" << std::setw(12) << "MB/s" << std::setw(10) << "+/- %" << endl;
+  for (auto&& b : benchmarks) {
+    if (b.first.find(program_args.filter) == std::string::npos) {
+      continue;
+    }
+
+    results.benchmarks.push_back(RunRepetitions(b.first, b.second));
+    OutputResult(results.benchmarks.back());
+  }
+
+  if (!program_args.json_filename.empty()) {
+    auto ofs = std::ofstream(program_args.json_filename);
+    WriteResults(ofs, results);
+    if (!ofs) {
+      cerr << program_args.json_filename << ": Cannot write results." << endl;
+      return 1;
+    }
+  }
+
+  if (!program_args.is_keep) {
+    std::remove(filename.c_str());
+    std::remove(sorted_filename.c_str());
+    std::remove(json_filename.c_str());
+  }
+
+  return 0;
+}
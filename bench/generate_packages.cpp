@@ -0,0 +1,89 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// This file generates a synthetic Packages file for benchmarking.
+//
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "package_generator.h"
+
+using std::cerr;
+using std::endl;
+
+namespace {
+/**
+ * @brief Outputs help text.
+ *
+ * @param s Name of the application
+ */
+void OutputHelp(const std::string& s) {
+  std::string message;
+  message += "Usage: " + s + " [OPTION]...\n";
+  message += "  -o, --output=[FILE]\twrite to [FILE] instead of stdout\n";
+  message += "      --size=[SIZE]\tgenerate [SIZE] bytes, e.g. 10MB or 10GB (default: 10MB)\n";
+  message += "      --seed=[N]\tseed of the generator (default: 1)\n";
+  message += "      --depth=[N]\tmaximum nesting depth of blocks (default: 4)\n";
+  message += "      --fields=[N]\taverage number of top-level fields per header (default: 12)\n";
+  message += "      --unparseable=[N]\tpercentage of headers with unparseable contents (default: 2)\n";
+  message += "      --lf\t\tend lines with LF instead of CRLF\n";
+  message += "      --help\t\tdisplay this help and exit\n";
+
+  std::cout << message << std::endl;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string> args(argv, argv + argc);
+
+  GeneratorOptions options;
+  std::string output;
+  for (auto it = args.begin() + 1; it != args.end(); ++it) {
+    if (*it == "--help") {
+      OutputHelp(args.at(0));
+      return 0;
+    } else if (*it == "-o" && it + 1 != args.end()) {
+      output = *++it;
+    } else if (it->substr(0, 9) == "--output=") {
+      output = it->substr(9);
+    } else if (it->substr(0, 7) == "--size=") {
+      if (!ParseSize(it->substr(7), &options.size)) {
+        cerr << "Invalid size: " << it->substr(7) << endl;
+        return 1;
+      }
+    } else if (it->substr(0, 7) == "--seed=") {
+      options.seed = std::stoull(it->substr(7));
+    } else if (it->substr(0, 8) == "--depth=") {
+      options.max_depth = static_cast<unsigned>(std::stoul(it->substr(8)));
+    } else if (it->substr(0, 9) == "--fields=") {
+      options.mean_fields = static_cast<unsigned>(std::stoul(it->substr(9)));
+    } else if (it->substr(0, 14) == "--unparseable=") {
+      options.unparseable_percent = static_cast<unsigned>(std::stoul(it->substr(14)));
+    } else if (*it == "--lf") {
+      options.is_crlf = false;
+    } else {
+      cerr << "Warning: Unrecognized option " << *it << endl;
+    }
+  }
+
+  GeneratorSummary summary;
+  if (output.empty()) {
+    summary = GeneratePackages(std::cout, options);
+    std::cout << std::flush;
+  } else {
+    auto ofs = std::ofstream(output, std::ios::binary);
+    if (!ofs) {
+      cerr << output << ": Cannot open file." << endl;
+      return 1;
+    }
+    summary = GeneratePackages(ofs, options);
+  }
+
+  cerr << "Generated " << summary.bytes << " bytes, " << summary.lines << " lines, " << summary.headers
+       << " headers, maximum depth " << summary.max_depth << endl;
+  return 0;
+}
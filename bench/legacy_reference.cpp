@@ -0,0 +1,412 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for legacy_reference.h
+//
+// These are copies of the original implementations, with logging, profiling and progress output removed. They must
+// keep producing the same output as the original implementations, so do not change them when optimizing the
+// implementations in the main program.
+//
+
+#include "legacy_reference.h"
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config_file.h"
+#include "packages.h"
+
+namespace {
+/**
+ * @brief Comparator which first compares the length of the strings, then compares the strings lexicographically.
+ */
+struct LegacyStrCompare {
+  bool operator()(const std::string& a, const std::string& b) const {
+    if (a.length() != b.length()) {
+      return b.length() < a.length();
+    }
+    return a < b;
+  }
+};
+
+using LegacyReplaceMap = std::map<std::string, std::string, LegacyStrCompare>;
+
+/**
+ * @brief Replacement pairs for syntactical constants.
+ */
+const LegacyReplaceMap kLegacySyntaxReplaceSet = {
+    {"=", ": "},
+    {"{}", "(empty hash)"},
+    {"[]", "(empty array)"},
+    {"\"\"", "(empty string)"}
+};
+/**
+ * @brief Replacement pairs for boolean constants.
+ */
+const LegacyReplaceMap kLegacyBoolReplaceSet = {
+    {"0", "false"},
+    {"1", "true"}
+};
+
+/**
+ * @brief Reads a section of replacement pairs from a prettify file.
+ *
+ * @param cf Prettify file
+ * @param section Name of the section
+ * @return Replacement pairs of the section in the order they are applied, or no pairs if the section does not exist
+ */
+auto ReadSection(ConfigFile& cf, const std::string& section) -> std::vector<std::pair<std::string, std::string>> {
+  auto replace_map = LegacyReplaceMap();
+  try {
+    for (auto&& set : cf.GetSection(section)) {
+      replace_map.emplace(set.first, set.second);
+    }
+  } catch (std::runtime_error&) {
+    // the section is not replaced
+  }
+  return std::vector<std::pair<std::string, std::string>>(replace_map.begin(), replace_map.end());
+}
+
+/**
+ * @brief Replaces the first occurrence of a pattern in a line.
+ *
+ * @param s Line
+ * @param pattern Pattern to replace
+ * @param replacement Replacement of the pattern
+ * @return True if the pattern is replaced
+ */
+bool ReplaceFirst(std::string& s, const std::string& pattern, const std::string& replacement) {
+  auto cmp = s.find(pattern);
+  if (cmp == std::string::npos) {
+    return false;
+  }
+  s.replace(cmp, pattern.length(), replacement);
+  return true;
+}
+
+/**
+ * @brief Replaces all tab characters with two spaces.
+ *
+ * @param str String to convert
+ */
+void LegacyConvertTabToSpace(std::string& str) {
+  std::string::size_type n = 0;
+  while ((n = str.find('\t', n)) != std::string::npos) {
+    str.replace(n, 1, "  ");
+    n += 2;
+  }
+}
+
+/**
+ * @brief Re-reads a whole file, grouping its lines by the header they lie under.
+ *
+ * @param filename Filename of the Packages file
+ * @param opt_mask Bit mask of @c Packages::SortOptions to apply
+ * @return Lines of each header, including the header line
+ */
+auto LegacyLoadFile(const std::string& filename, unsigned opt_mask) -> std::map<std::string, std::vector<std::string>> {
+  auto instream = std::ifstream(filename);
+  auto contents = std::map<std::string, std::vector<std::string>>();
+  const bool is_diff = (opt_mask & static_cast<unsigned>(Packages::SortOptions::kDiff)) != 0;
+
+  std::string category;
+  std::string buffer_line;
+  while (getline(instream, buffer_line)) {
+    if (buffer_line.empty()) {
+      continue;
+    }
+
+    if (buffer_line.back() == '\r') {
+      buffer_line.pop_back();
+    }
+
+    auto start_of_category = buffer_line.find("FullPackageName=");
+    if (start_of_category != std::string::npos) {
+      category = buffer_line.substr(start_of_category + 16);
+      contents.emplace(category, std::vector<std::string>());
+      if (is_diff && buffer_line.front() == '~') {
+        buffer_line.erase(0, 1);
+      }
+      contents.at(category).emplace_back(buffer_line);
+    } else if (category.empty()) {
+      continue;
+    } else {
+      LegacyConvertTabToSpace(buffer_line);
+      if (is_diff && buffer_line.substr(0, 12) == "BasePackage=") {
+        buffer_line.insert(0, "  ");
+      }
+      contents.at(category).emplace_back(buffer_line);
+    }
+  }
+
+  return contents;
+}
+
+/**
+ * @brief Converts the lines of a header into JSON format.
+ *
+ * @param lines Lines of the header, including the header line
+ * @return JSON-formatted header, or no lines if the header cannot be converted
+ */
+auto LegacyHeaderToJson(std::vector<std::string> lines) -> std::vector<std::string> {
+  std::vector<std::pair<char, std::string>> st;
+  int indent = 0;
+
+  std::vector<std::string> parsed;
+  parsed.emplace_back("{");
+  indent += 2;
+
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    std::string& line = *it;
+
+    while (!line.empty() && line.front() == ' ') {
+      line.erase(0, 1);
+    }
+
+    std::string::size_type entry_token = line.find('=');
+    std::string::size_type barray_token = line.find("=[");
+    std::string::size_type bobject_token = line.find("={");
+    bool aobject_token = line == "{";
+    bool aarray_token = line == "[";
+    bool earray_token = line == "]" || line == "],";
+    bool eobject_token = line == "}" || line == "},";
+
+    if (line.find("UNPARSEABLEcONTENTS") != std::string::npos) {
+      continue;
+    }
+
+    if (line.find("[]") != std::string::npos) {
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + line.substr(0, barray_token) + R"(":[],)");
+      continue;
+    }
+
+    if (line.find("{}") != std::string::npos) {
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + line.substr(0, bobject_token) + R"(":{},)");
+      continue;
+    }
+
+    if (earray_token) {
+      if (!st.empty() && st.back().first == '[') {
+        st.pop_back();
+
+        indent -= 2;
+        parsed.emplace_back(std::string(unsigned(indent), ' ') + "]");
+      }
+    } else if (barray_token != std::string::npos) {
+      st.emplace_back('[', line.substr(0, barray_token) + "[]");
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + line.substr(0, barray_token) + R"(":[)");
+      indent += 2;
+
+      continue;
+    } else if (eobject_token) {
+      if (!st.empty() && st.back().first == '{') {
+        st.pop_back();
+
+        indent -= 2;
+        parsed.emplace_back(std::string(unsigned(indent), ' ') + "}");
+      }
+    } else if (aobject_token) {
+      st.emplace_back('{', "{}");
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "{");
+      indent += 2;
+
+      continue;
+    } else if (aarray_token) {
+      st.emplace_back('[', "[]");
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "[");
+      indent += 2;
+
+      continue;
+    } else if (bobject_token != std::string::npos) {
+      st.emplace_back('{', line.substr(0, bobject_token) + "{}");
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + line.substr(0, bobject_token) + R"(":{)");
+      indent += 2;
+
+      continue;
+    } else if (entry_token != std::string::npos) {
+      const std::string key = line.substr(0, entry_token);
+      if (line.substr(entry_token + 1) == "\"\"") {
+        parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + key + R"(":"")");
+      } else {
+        parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + key + R"(":")" +
+                            line.substr(entry_token + 1) + "\"");
+      }
+    } else {
+      if (!line.empty() && line.back() == ',') {
+        line.pop_back();
+      }
+      parsed.emplace_back(std::string(unsigned(indent), ' ') + "\"" + line + "\"");
+    }
+
+    if ((it + 1) != lines.end() &&
+        ((it + 1)->find("[]") != std::string::npos || (it + 1)->find("{}") != std::string::npos ||
+         ((it + 1)->find(']') == std::string::npos && (it + 1)->find('}') == std::string::npos))) {
+      parsed.back().push_back(',');
+    }
+  }
+
+  indent -= 2;
+  parsed.emplace_back("}");
+
+  if (!st.empty() || indent != 0) {
+    parsed.clear();
+  }
+
+  return parsed;
+}
+
+/**
+ * @brief Retrieves the contents of a header, excluding the header line.
+ *
+ * @param filename Filename of the Packages file
+ * @param line Zero-based line number of the header line
+ * @return All lines of the header
+ */
+auto LegacyGetHeaderContents(const std::string& filename, unsigned line) -> std::vector<std::string> {
+  auto content = std::vector<std::string>();
+
+  auto fs = std::ifstream(filename);
+  std::string buffer_line;
+  for (unsigned it = 0; it <= line && getline(fs, buffer_line); ++it) {
+    // skip all lines up to and including the header line
+  }
+
+  for (bool is_first = true; getline(fs, buffer_line); is_first = false) {
+    if (!is_first && buffer_line.find("FullPackageName=") != std::string::npos) {
+      break;
+    }
+
+    if (!buffer_line.empty() && buffer_line.back() == '\r') {
+      buffer_line.pop_back();
+    }
+
+    LegacyConvertTabToSpace(buffer_line);
+    content.push_back(buffer_line);
+  }
+
+  return content;
+}
+}  // namespace
+
+LegacyPrettifier::LegacyPrettifier(const std::string& filename) {
+  ConfigFile cf(filename);
+  if (cf.ReadFromFile()) {
+    norm_replace_set_ = ReadSection(cf, "normal");
+    bool_replace_set_ = ReadSection(cf, "bool");
+    lotus_replace_set_ = ReadSection(cf, "lotus");
+  }
+}
+
+LegacyPrettifier::~LegacyPrettifier() = default;
+
+void LegacyPrettifier::PrettifyLine(std::string& s) const {
+  for (const auto& p_replace : kLegacySyntaxReplaceSet) {
+    ReplaceFirst(s, p_replace.first, p_replace.second);
+  }
+
+  for (const auto& p_replace : norm_replace_set_) {
+    ReplaceFirst(s, p_replace.first, p_replace.second);
+  }
+
+  for (const auto& p_replace : bool_replace_set_) {
+    if (ReplaceFirst(s, p_replace.first, p_replace.second)) {
+      // also replace the first boolean value
+      for (const auto& p_bool : kLegacyBoolReplaceSet) {
+        if (ReplaceFirst(s, p_bool.first, p_bool.second)) {
+          break;
+        }
+      }
+    }
+  }
+
+  for (const auto& p_replace : lotus_replace_set_) {
+    ReplaceFirst(s, p_replace.first, p_replace.second);
+  }
+}
+
+auto LegacyParseFile(const std::string& filename) -> std::map<std::string, unsigned> {
+  auto headers = std::map<std::string, unsigned>();
+
+  auto ifs = std::ifstream(filename);
+  std::string buffer_line;
+  for (unsigned i = 0; getline(ifs, buffer_line); ++i) {
+    auto start_of_category = buffer_line.find("FullPackageName=");
+    if (start_of_category != std::string::npos) {
+      if (buffer_line.back() == '\r') {
+        buffer_line.pop_back();
+      }
+      headers.emplace(buffer_line.substr(start_of_category + 16), i);
+    }
+  }
+
+  return headers;
+}
+
+void LegacySortFile(const std::string& filename, const std::string& outfile, unsigned opt_mask,
+                    const LegacyPrettifier& prettifier) {
+  const auto contents = LegacyLoadFile(filename, opt_mask);
+  const bool is_prettify = (opt_mask & static_cast<unsigned>(Packages::SortOptions::kPrettify)) != 0;
+
+  auto outstream = std::ofstream(outfile);
+  for (auto&& p : contents) {
+    for (auto l : p.second) {
+      if (is_prettify) {
+        prettifier.PrettifyLine(l);
+      }
+
+      outstream << l << '\n';
+    }
+    outstream.flush();
+  }
+}
+
+void LegacyDumpJson(const std::string& filename, const std::string& outfile) {
+  auto contents = LegacyLoadFile(filename, 0);
+
+  auto outstream = std::ofstream(outfile);
+  for (auto&& h : contents) {
+    for (auto&& l : LegacyHeaderToJson(std::move(h.second))) {
+      outstream << l << '\n';
+    }
+    outstream.flush();
+  }
+}
+
+void LegacyOutputHeader(const std::string& filename, const std::map<std::string, unsigned>& headers,
+                        const std::string& header, bool is_raw, const LegacyPrettifier& prettifier, std::ostream& os) {
+  auto search = headers.find(header);
+  if (search == headers.end()) {
+    os << header << ": Header not found." << '\n';
+    return;
+  }
+
+  os << "Loading entry..." << '\n';
+  std::vector<std::string> contents = LegacyGetHeaderContents(filename, search->second);
+
+  os << "Package Name: " << header << '\n';
+  if (is_raw) {
+    os << "Line Number in File: " << search->second + 1 << '\n';
+    os << '\n';
+
+    for (auto&& l : contents) {
+      os << l << '\n';
+    }
+  } else {
+    if (!contents.empty() && contents[0].find("BasePackage=") != std::string::npos) {
+      os << "Base Package: " << contents[0].substr(contents[0].find("BasePackage=") + 12) << '\n';
+      contents.erase(contents.begin());
+    }
+    os << '\n';
+    os << "Line Number in File: " << search->second + 1 << '\n';
+    os << '\n';
+
+    for (auto& l : contents) {
+      prettifier.PrettifyLine(l);
+      os << l << '\n';
+    }
+  }
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Reference implementations of the original sort, JSON and view paths, for checking the optimized paths against.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_BENCH_LEGACY_REFERENCE_H_
+#define WARFRAME_PACKAGES_DEPARSER_BENCH_LEGACY_REFERENCE_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Prettifier which applies the replacement pairs of a prettify file by searching for every pair in turn.
+ *
+ * This is the original implementation of prettifying. It is kept as simple as possible, so that it is obviously
+ * correct, and should not be optimized.
+ */
+class LegacyPrettifier {
+ public:
+  /**
+   * Reads the replacement pairs from a prettify file. If the file cannot be read, only syntactical constants are
+   * replaced.
+   *
+   * @param filename Filename of the prettify file
+   */
+  explicit LegacyPrettifier(const std::string& filename);
+  LegacyPrettifier(const LegacyPrettifier&) = delete;
+  auto operator=(const LegacyPrettifier&) -> LegacyPrettifier& = delete;
+  ~LegacyPrettifier();
+
+  /**
+   * Prettifies a line.
+   *
+   * @param s Line to be prettified
+   */
+  void PrettifyLine(std::string& s) const;
+
+ private:
+  /**
+   * Replacement pairs, ordered by descending length and then lexicographically.
+   */
+  using ReplaceSet = std::vector<std::pair<std::string, std::string>>;
+
+  ReplaceSet norm_replace_set_;
+  ReplaceSet bool_replace_set_;
+  ReplaceSet lotus_replace_set_;
+};
+
+/**
+ * Finds all headers of a file, in the same way as the original @c Packages::ParseFile.
+ *
+ * @param filename Filename of the Packages file
+ * @return Zero-based line number of the first occurrence of each header
+ */
+auto LegacyParseFile(const std::string& filename) -> std::map<std::string, unsigned>;
+
+/**
+ * Sorts a file lexicographically, in the same way as the original @c Packages::SortFile.
+ *
+ * @param filename Filename of the Packages file
+ * @param outfile Filename of the output
+ * @param opt_mask Bit mask of @c Packages::SortOptions to apply
+ * @param prettifier Prettifier to use if prettifying
+ */
+void LegacySortFile(const std::string& filename, const std::string& outfile, unsigned opt_mask,
+                    const LegacyPrettifier& prettifier);
+
+/**
+ * Converts a file into JSON format, in the same way as the original @c Packages::DumpJson.
+ *
+ * @param filename Filename of the Packages file
+ * @param outfile Filename of the output
+ */
+void LegacyDumpJson(const std::string& filename, const std::string& outfile);
+
+/**
+ * Outputs the contents of a header, in the same way as the original @c Packages::OutputHeader with clearing the
+ * screen disabled.
+ *
+ * @param filename Filename of the Packages file
+ * @param headers Headers of the file, as returned by @c LegacyParseFile
+ * @param header Target header
+ * @param is_raw Whether to output the contents in the raw format
+ * @param prettifier Prettifier to use if not outputting the raw format
+ * @param os Stream to output to
+ */
+void LegacyOutputHeader(const std::string& filename, const std::map<std::string, unsigned>& headers,
+                        const std::string& header, bool is_raw, const LegacyPrettifier& prettifier, std::ostream& os);
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_BENCH_LEGACY_REFERENCE_H_
@@ -0,0 +1,295 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for generating synthetic Packages files.
+//
+
+#include "package_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <string>
+
+namespace {
+/**
+ * @brief Deterministic pseudo-random number generator (xorshift64*).
+ *
+ * Standard distributions are implementation-defined, so all sampling is done here to generate the same file on every
+ * platform.
+ */
+class Random {
+ public:
+  explicit Random(std::uint64_t seed) : state_(seed == 0 ? 0x9E3779B97F4A7C15 : seed) {}
+
+  auto Next() -> std::uint64_t {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 0x2545F4914F6CDD1D;
+  }
+
+  /**
+   * @return Uniformly distributed integer in [0, n)
+   */
+  auto Uniform(std::uint64_t n) -> std::uint64_t { return (Next() >> 11) % n; }
+
+  /**
+   * @return True with the given probability in percent
+   */
+  auto Chance(unsigned percent) -> bool { return Uniform(100) < percent; }
+
+  template<typename T, std::size_t N>
+  auto Pick(const std::array<T, N>& items) -> const T& {
+    return items[Uniform(N)];
+  }
+
+ private:
+  std::uint64_t state_;
+};
+
+const std::array<const char*, 10> kPathRoots = {{
+    "/Lotus/Types/Items/", "/Lotus/Types/Recipes/", "/Lotus/Weapons/Tenno/", "/Lotus/Weapons/Grineer/",
+    "/Lotus/Weapons/Corpus/", "/Lotus/Powersuits/", "/Lotus/Upgrades/Mods/", "/Lotus/Types/Enemies/",
+    "/Lotus/Interface/Icons/", "/Lotus/Levels/",
+}};
+const std::array<const char*, 16> kPathWords = {{
+    "Archwing", "Melee", "Pistols", "Rifles", "Shotguns", "Primary", "Secondary", "Warframe",
+    "Sentinel", "Kubrow", "Relics", "Arcane", "Syndicate", "Void", "Orokin", "Infested",
+}};
+const std::array<const char*, 14> kNameWords = {{
+    "Excalibur", "Braton", "Lato", "Skana", "Soma", "Boltor", "Paris", "Hek", "Nova", "Rhino", "Vauban", "Trinity",
+    "Orthos", "Dread",
+}};
+const std::array<const char*, 8> kNameSuffixes = {{"", "Prime", "Blueprint", "Component", "Skin", "Helmet", "Wraith",
+                                                    "Vandal"}};
+const std::array<const char*, 5> kMaterials = {{
+    "/Lotus/Types/Items/MiscItems/AlloyPlate", "/Lotus/Types/Items/MiscItems/Circuits",
+    "/Lotus/Types/Items/MiscItems/ControlModule", "/Lotus/Types/Items/MiscItems/Ferrite",
+    "/Lotus/Types/Items/MiscItems/Rubedo",
+}};
+
+/**
+ * @brief Kind of value a field holds.
+ */
+enum struct ValueKind { kInteger, kFloat, kBool, kEnum, kPath, kString };
+
+/**
+ * @brief Field which may appear in a header, with how often it appears relative to the others.
+ */
+struct Field {
+  const char* name;
+  ValueKind kind;
+  unsigned weight;
+};
+
+const std::array<Field, 32> kFields = {{
+    {"BuildPrice", ValueKind::kInteger, 4},         {"BuildTime", ValueKind::kInteger, 4},
+    {"SkipBuildTimePrice", ValueKind::kInteger, 3}, {"ItemCount", ValueKind::kInteger, 6},
+    {"PremiumPrice", ValueKind::kInteger, 3},       {"RegularPrice", ValueKind::kInteger, 3},
+    {"SellingPrice", ValueKind::kInteger, 3},       {"PrimeSellingPrice", ValueKind::kInteger, 1},
+    {"RequiredLevel", ValueKind::kInteger, 2},      {"ResearchTime", ValueKind::kInteger, 1},
+    {"InitialEnergy", ValueKind::kFloat, 2},        {"MaxEnergy", ValueKind::kFloat, 2},
+    {"MaxShieldOverride", ValueKind::kFloat, 1},    {"ArmourRatingOverride", ValueKind::kFloat, 1},
+    {"AlwaysAvailable", ValueKind::kBool, 2},       {"AvailableOnPvp", ValueKind::kBool, 2},
+    {"CanEnhance", ValueKind::kBool, 1},            {"ExcludeFromCodex", ValueKind::kBool, 2},
+    {"Giftable", ValueKind::kBool, 2},              {"IsPrime", ValueKind::kBool, 2},
+    {"ShowInMarket", ValueKind::kBool, 3},          {"Tradeable", ValueKind::kBool, 3},
+    {"MarketMode", ValueKind::kEnum, 3},            {"MaxResolution", ValueKind::kEnum, 1},
+    {"ArtifactPolarity", ValueKind::kEnum, 2},      {"ItemType", ValueKind::kPath, 6},
+    {"ResultItem", ValueKind::kPath, 2},            {"IconTexture", ValueKind::kPath, 4},
+    {"ProductCategory", ValueKind::kString, 3},     {"LocalizeTag", ValueKind::kString, 5},
+    {"LocalizeDescTag", ValueKind::kString, 4},     {"TypeName", ValueKind::kString, 2},
+}};
+const std::array<const char*, 8> kBlockNames = {{
+    "Ingredients", "Upgrades", "DefaultCustomization", "ArtifactSlots", "Behaviors", "Abilities", "Compatible",
+    "Rewards",
+}};
+const std::array<const char*, 10> kEnumValues = {{
+    "MM_HIDDEN", "MM_VISIBLE", "MR_256", "MR_2048", "MR_4096", "AP_ATTACK", "AP_DEFENSE", "AP_TACTIC",
+    "AP_UNIVERSAL", "RO_ALWAYS",
+}};
+
+/**
+ * @brief Writer of the lines of a Packages file, which tracks the size of the output.
+ */
+class Writer {
+ public:
+  Writer(std::ostream* os, const GeneratorOptions& options) : os_(os), random_(options.seed), options_(options) {
+    for (auto&& f : kFields) {
+      total_weight_ += f.weight;
+    }
+  }
+
+  auto GetSummary() const -> const GeneratorSummary& { return summary_; }
+
+  void WriteHeader() {
+    const std::string name = MakePath(kPathRoots[summary_.headers % kPathRoots.size()]) + "_" +
+                             std::to_string(summary_.headers);
+    WriteLine(0, "~FullPackageName=" + name);
+    ++summary_.headers;
+
+    if (random_.Chance(80)) {
+      WriteLine(0, "BasePackage=" + MakePath(random_.Pick(kPathRoots)));
+    }
+
+    const unsigned field_count = static_cast<unsigned>(random_.Uniform(2 * options_.mean_fields + 1));
+    for (unsigned i = 0; i < field_count; ++i) {
+      WriteMember(1, random_.Pick(kBlockNames));
+    }
+
+    if (random_.Chance(options_.unparseable_percent)) {
+      WriteLine(1, "UNPARSEABLEcONTENTS");
+    }
+  }
+
+ private:
+  /**
+   * @brief Writes a field, or occasionally a block of fields.
+   *
+   * @param depth Depth of the field
+   * @param block_name Name of the block, if a block is written
+   */
+  void WriteMember(unsigned depth, const char* block_name) {
+    if (depth <= options_.max_depth && random_.Chance(depth == 1 ? 15 : 8)) {
+      WriteBlock(depth, block_name);
+    } else {
+      const Field& f = PickField();
+      WriteLine(depth, std::string(f.name) + "=" + MakeValue(f.kind));
+    }
+  }
+
+  /**
+   * @brief Writes an object or array block, which may be empty.
+   *
+   * @param depth Depth of the block
+   * @param name Name of the block
+   */
+  void WriteBlock(unsigned depth, const char* name) {
+    summary_.max_depth = std::max(summary_.max_depth, depth);
+
+    const bool is_array = random_.Chance(60);
+    const unsigned count = static_cast<unsigned>(random_.Uniform(5));
+    if (count == 0) {
+      WriteLine(depth, std::string(name) + (is_array ? "=[]" : "={}"));
+      return;
+    }
+
+    WriteLine(depth, std::string(name) + (is_array ? "=[" : "={"));
+    for (unsigned i = 0; i < count; ++i) {
+      if (is_array && random_.Chance(70)) {
+        // arrays mostly hold anonymous objects, such as the ingredients of a recipe
+        WriteLine(depth + 1, "{");
+        const unsigned member_count = 1 + static_cast<unsigned>(random_.Uniform(3));
+        for (unsigned j = 0; j < member_count; ++j) {
+          WriteMember(depth + 2, random_.Pick(kBlockNames));
+        }
+        WriteLine(depth + 1, "},");
+      } else if (is_array) {
+        WriteLine(depth + 1, MakeValue(ValueKind::kPath) + ",");
+      } else {
+        WriteMember(depth + 1, random_.Pick(kBlockNames));
+      }
+    }
+    WriteLine(depth, is_array ? "]," : "},");
+  }
+
+  auto PickField() -> const Field& {
+    std::uint64_t target = random_.Uniform(total_weight_);
+    for (auto&& f : kFields) {
+      if (target < f.weight) {
+        return f;
+      }
+      target -= f.weight;
+    }
+    return kFields.back();
+  }
+
+  auto MakePath(const char* root) -> std::string {
+    std::string path = root;
+    const unsigned depth = 1 + static_cast<unsigned>(random_.Uniform(3));
+    for (unsigned i = 0; i < depth; ++i) {
+      path += random_.Pick(kPathWords);
+      path += '/';
+    }
+    path += random_.Pick(kNameWords);
+    path += random_.Pick(kNameSuffixes);
+    return path;
+  }
+
+  auto MakeValue(ValueKind kind) -> std::string {
+    switch (kind) {
+      case ValueKind::kInteger:
+        return std::to_string(random_.Uniform(random_.Chance(50) ? 100 : 100000));
+      case ValueKind::kFloat:
+        return std::to_string(random_.Uniform(1000)) + "." + std::to_string(random_.Uniform(10));
+      case ValueKind::kBool:
+        return random_.Chance(50) ? "1" : "0";
+      case ValueKind::kEnum:
+        return random_.Pick(kEnumValues);
+      case ValueKind::kPath:
+        return random_.Chance(40) ? random_.Pick(kMaterials) : MakePath(random_.Pick(kPathRoots));
+      case ValueKind::kString:
+        return random_.Chance(20) ? "\"\"" : "\"/Lotus/Language/" + std::string(random_.Pick(kNameWords)) + "\"";
+      default:
+        // all cases covered
+        return "";
+    }
+  }
+
+  void WriteLine(unsigned depth, const std::string& line) {
+    const std::string indent(depth, '\t');
+    const char* eol = options_.is_crlf ? "\r\n" : "\n";
+    *os_ << indent << line << eol;
+
+    summary_.bytes += indent.size() + line.size() + (options_.is_crlf ? 2 : 1);
+    ++summary_.lines;
+  }
+
+  std::ostream* os_;
+  Random random_;
+  const GeneratorOptions& options_;
+  std::uint64_t total_weight_ = 0;
+  GeneratorSummary summary_;
+};
+}  // namespace
+
+auto GeneratePackages(std::ostream& os, const GeneratorOptions& options) -> GeneratorSummary {
+  Writer w(&os, options);
+  while (w.GetSummary().bytes < options.size) {
+    w.WriteHeader();
+  }
+  return w.GetSummary();
+}
+
+auto ParseSize(const std::string& str, std::uint64_t* const size) -> bool {
+  std::size_t end = 0;
+  while (end < str.size() && std::isdigit(static_cast<unsigned char>(str[end]))) {
+    ++end;
+  }
+  if (end == 0) {
+    return false;
+  }
+
+  std::string unit = str.substr(end);
+  for (auto&& c : unit) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+
+  std::uint64_t multiplier = 0;
+  if (unit.empty() || unit == "B") {
+    multiplier = 1;
+  } else if (unit == "KB" || unit == "K") {
+    multiplier = std::uint64_t{1} << 10;
+  } else if (unit == "MB" || unit == "M") {
+    multiplier = std::uint64_t{1} << 20;
+  } else if (unit == "GB" || unit == "G") {
+    multiplier = std::uint64_t{1} << 30;
+  } else {
+    return false;
+  }
+
+  *size = std::stoull(str.substr(0, end)) * multiplier;
+  return true;
+}
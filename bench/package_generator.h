@@ -0,0 +1,76 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for generating synthetic Packages files.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_BENCH_PACKAGE_GENERATOR_H_
+#define WARFRAME_PACKAGES_DEPARSER_BENCH_PACKAGE_GENERATOR_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Options of a generated Packages file.
+ */
+struct GeneratorOptions {
+  /**
+   * @brief Size of the file in bytes. Generation stops at the first header which reaches this size.
+   */
+  std::uint64_t size = 10 * 1024 * 1024;
+  /**
+   * @brief Seed of the generator. The same options always generate the same file.
+   */
+  std::uint64_t seed = 1;
+  /**
+   * @brief Maximum nesting depth of blocks within a header.
+   */
+  unsigned max_depth = 4;
+  /**
+   * @brief Average number of top-level fields per header.
+   */
+  unsigned mean_fields = 12;
+  /**
+   * @brief Percentage of headers containing unparseable contents.
+   */
+  unsigned unparseable_percent = 2;
+  /**
+   * @brief Whether to end lines with CRLF, as in files dumped on Windows.
+   */
+  bool is_crlf = true;
+};
+
+/**
+ * @brief Summary of a generated Packages file.
+ */
+struct GeneratorSummary {
+  std::uint64_t bytes = 0;
+  std::uint64_t lines = 0;
+  std::uint64_t headers = 0;
+  unsigned max_depth = 0;
+};
+
+/**
+ * Generates a synthetic Packages file.
+ *
+ * Each header begins with a @c ~FullPackageName= line as in datamined files, usually followed by a @c BasePackage= line and a mix of fields,
+ * including enumerations, booleans, paths, strings and nested @c ={ and @c =[ blocks. Some headers contain
+ * @c UNPARSEABLEcONTENTS.
+ *
+ * @param os Stream to output to
+ * @param options Options of the file
+ * @return Summary of the file
+ */
+auto GeneratePackages(std::ostream& os, const GeneratorOptions& options) -> GeneratorSummary;
+
+/**
+ * Parses a size with an optional unit, such as @c 512KB, @c 10MB or @c 10GB. Units are powers of 1024.
+ *
+ * @param str String to parse
+ * @param size Parsed size in bytes
+ * @return True if successful
+ */
+auto ParseSize(const std::string& str, std::uint64_t* size) -> bool;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_BENCH_PACKAGE_GENERATOR_H_
@@ -0,0 +1,108 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for FuzzyMatcher class.
+//
+
+#include "fuzzy_match.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr unsigned kWordSize = 64;
+
+/**
+ * @brief Computes one column of a single block of the dynamic programming matrix.
+ *
+ * @param pv Positive vertical delta vector of the block
+ * @param mv Negative vertical delta vector of the block
+ * @param eq Match mask of the current text character
+ * @param hin Horizontal delta entering the block from above
+ * @param high_bit Bit of the last row in the block
+ * @return Horizontal delta leaving the block from below
+ */
+inline int AdvanceBlock(std::uint64_t& pv, std::uint64_t& mv, std::uint64_t eq, int hin, std::uint64_t high_bit) {
+  const std::uint64_t xv = eq | mv;
+  if (hin < 0) {
+    eq |= 1;
+  }
+  const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+  std::uint64_t ph = mv | ~(xh | pv);
+  std::uint64_t mh = pv & xh;
+
+  int hout = 0;
+  if (ph & high_bit) {
+    hout = 1;
+  } else if (mh & high_bit) {
+    hout = -1;
+  }
+
+  ph <<= 1;
+  mh <<= 1;
+  if (hin < 0) {
+    mh |= 1;
+  } else if (hin > 0) {
+    ph |= 1;
+  }
+
+  pv = mh | ~(xv | ph);
+  mv = ph & xv;
+
+  return hout;
+}
+}  // namespace
+
+FuzzyMatcher::FuzzyMatcher(const std::string& pattern)
+    : length_(static_cast<unsigned>(pattern.size())), blocks_((pattern.size() + kWordSize - 1) / kWordSize) {
+  last_bit_ = length_ == 0 ? 0 : std::uint64_t{1} << ((length_ - 1) % kWordSize);
+  peq_.assign(256 * blocks_, 0);
+
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    const auto c = static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(pattern[i])));
+    peq_[c * blocks_ + i / kWordSize] |= std::uint64_t{1} << (i % kWordSize);
+  }
+}
+
+auto FuzzyMatcher::Distance(const std::string& text) const -> unsigned {
+  if (length_ == 0) {
+    return 0;
+  }
+
+  unsigned score = length_;
+  unsigned best = score;
+
+  // fast path: the pattern fits in a single machine word
+  if (blocks_ == 1) {
+    std::uint64_t pv = ~std::uint64_t{0};
+    std::uint64_t mv = 0;
+    for (const char ch : text) {
+      const auto c = static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(ch)));
+      const int h = AdvanceBlock(pv, mv, peq_[c], 0, last_bit_);
+      score = static_cast<unsigned>(static_cast<int>(score) + h);
+      best = std::min(best, score);
+    }
+    return best;
+  }
+
+  auto pv = std::vector<std::uint64_t>(blocks_, ~std::uint64_t{0});
+  auto mv = std::vector<std::uint64_t>(blocks_, 0);
+  for (const char ch : text) {
+    const auto c = static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(ch)));
+    const std::uint64_t* eq = &peq_[c * blocks_];
+
+    // the top row is always zero, as the match may begin anywhere in the text
+    int h = 0;
+    for (std::size_t b = 0; b < blocks_; ++b) {
+      const std::uint64_t high_bit = b + 1 == blocks_ ? last_bit_ : std::uint64_t{1} << (kWordSize - 1);
+      h = AdvanceBlock(pv[b], mv[b], eq[b], h, high_bit);
+    }
+    score = static_cast<unsigned>(static_cast<int>(score) + h);
+    best = std::min(best, score);
+  }
+
+  return best;
+}
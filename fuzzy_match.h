@@ -0,0 +1,54 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for approximate string matching.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_FUZZY_MATCH_H_
+#define WARFRAME_PACKAGES_DEPARSER_FUZZY_MATCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Case-insensitive approximate matcher using the bit-parallel algorithm of Myers, in the block-based formulation
+ * by Hyyro.
+ *
+ * The matcher computes the minimum edit distance between the pattern and any substring of a text, so that a query
+ * matches a header if it is close to some part of the header.
+ */
+class FuzzyMatcher {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param pattern Pattern to match against
+   */
+  explicit FuzzyMatcher(const std::string& pattern);
+
+  /**
+   * Computes the minimum edit distance between the pattern and any substring of the text.
+   *
+   * @param text Text to search in
+   * @return Edit distance
+   */
+  auto Distance(const std::string& text) const -> unsigned;
+
+  /**
+   * @return Length of the pattern
+   */
+  auto GetLength() const -> unsigned { return length_; }
+
+ private:
+  unsigned length_ = 0;
+  std::size_t blocks_ = 0;
+  std::uint64_t last_bit_ = 0;
+
+  /**
+   * @brief Match masks of the pattern, indexed by [character * blocks_ + block].
+   */
+  std::vector<std::uint64_t> peq_;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_FUZZY_MATCH_H_
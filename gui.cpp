@@ -6,6 +6,8 @@
 
 #include "gui.h"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <vector>
@@ -21,15 +23,24 @@ using std::cout;
 using std::endl;
 using std::getline;
 
-Gui::Gui(Packages* package) : packages_(package)
+Gui::Gui(Packages* package, PackageStore* store) : packages_(package), store_(store)
 {}
 
 void Gui::MainMenu() {
   Cui c(Cui::HintLevel::kNone);
   c.AddItem("Find", "find", std::bind(&Gui::Find, this, std::placeholders::_1, true));
+  c.AddItem("Search", "search", std::bind(&Gui::Search, this, std::placeholders::_1));
+  c.AddItem("Grep", "grep", std::bind(&Gui::Grep, this, std::placeholders::_1));
   c.AddItem("View", "view", std::bind(&Gui::View, this, std::placeholders::_1));
+  c.AddItem("Lines", "lines", std::bind(&Gui::Lines, this, std::placeholders::_1));
   c.AddItem("Sort", "sort", std::bind(&Gui::Sort, this, std::placeholders::_1));
   c.AddItem("Compare", "compare", std::bind(&Gui::Compare, this, std::placeholders::_1));
+  c.AddItem("Compare Many", "compare-many", std::bind(&Gui::CompareMany, this, std::placeholders::_1));
+  c.AddItem("Diff", "diff", std::bind(&Gui::Diff, this, std::placeholders::_1));
+  c.AddItem("Unified Diff", "udiff", std::bind(&Gui::UnifiedDiff, this, std::placeholders::_1));
+  c.AddItem("Store", "store", std::bind(&Gui::Store, this, std::placeholders::_1));
+  c.AddItem("Reload", "reload", std::bind(&Gui::Reload, this, std::placeholders::_1));
+  c.AddItem("Stats", "stats", std::bind(&Gui::Stats, this, std::placeholders::_1));
   c.AddItem("json-struct", "json-struct", std::bind(&Gui::JsonStructure, this, std::placeholders::_1));
   c.AddItem("json-dump", "json-dump", std::bind(&Gui::JsonDump, this, std::placeholders::_1));
   c.AddItem("Help", "help", std::bind(&Gui::Help, this, true));
@@ -49,7 +60,7 @@ void Gui::MainMenu() {
     b = c.Inflate(true, true);
   }
 
-  Log::i("Exiting interactive loop...");
+  LOG_I("Exiting interactive loop...");
 }
 
 auto Gui::GetFileName() const -> std::string {
@@ -77,10 +88,27 @@ void Gui::Help(bool is_interactive) const {
   cout << "\tPrompt user if there are more than [count] results." << '\n';
   cout << "\t[-f]: Only show results beginning with [string]." << '\n';
   cout << '\n';
+  cout << "find ~[string] [top=10]: Find the [top] packages closest to [string] by edit distance." << '\n';
+  cout << '\n';
   cout << "find line=[line]: Reverse lookup package name at [line]" << '\n';
   cout << '\n';
-  cout << "view [--raw] [package]: View the data of [package]" << '\n';
+  cout << "find lines=[file]: Reverse lookup package names of all line numbers in [file]" << '\n';
+  cout << "\tUse '-' as [file] to read line numbers from standard input, up to a line containing only '.'." << '\n';
+  cout << '\n';
+  cout << "search [--rebuild] [term]...: Find packages whose contents contain all [term]s." << '\n';
+  cout << "\t[term] is either a token (e.g. /Lotus/Upgrades/Mods/Foo) or a pair (e.g. ProductCategory=Pistols)." << '\n';
+  cout << "\tA [term] ending with '*' matches all tokens and pairs beginning with [term]." << '\n';
+  cout << "\tThe search index is saved next to the loaded file. Use [--rebuild] to force rebuilding it." << '\n';
+  cout << '\n';
+  cout << "grep [--regex] [--lines] [pattern]: Find packages containing a line matching [pattern]." << '\n';
+  cout << "\tBy default [pattern] is matched literally. Use [--regex] to match a regular expression instead." << '\n';
+  cout << "\tUse [--lines] to also show all matching lines." << '\n';
+  cout << '\n';
+  cout << "view [--raw] [--version=VERSION] [package]: View the data of [package]" << '\n';
   cout << "\t[--raw]: Show the raw version as opposed to prettify version." << '\n';
+  cout << "\t[--version]: Show [package] as of [VERSION] in the package store." << '\n';
+  cout << '\n';
+  cout << "lines [from] [to]: Show lines [from] to [to] of the file." << '\n';
   cout << '\n';
   cout << "sort [OPTIONS...]: Sort and output the file to out.txt" << '\n';
   cout << "\tBy default a diff-optimized format will be output. Use [--no-diff] to use the legacy format." << '\n';
@@ -90,7 +118,36 @@ void Gui::Help(bool is_interactive) const {
   cout << "\tShow progress every [count] headers dumped." << '\n';
   cout << "\tSorted file will be dumped to [filename]." << '\n';
   cout << '\n';
-  cout << "compare [filename]: Compares the headers of the currently loaded file with [filename]" << '\n';
+  cout << "compare [filename]: Compares the headers and contents of the currently loaded file with [filename]" << '\n';
+  cout << '\n';
+  cout << "compare-many [--all] [filename]...: Compares the headers and contents across all [filename]s" << '\n';
+  cout << "\tShows the first file and last file containing each header, and the files where it is removed, added back" << '\n';
+  cout << "\tor its contents change, compared with the file before." << '\n';
+  cout << "\tFiles are numbered in the given order. Use [--all] to also show headers identical across all files." << '\n';
+  cout << '\n';
+  cout << "diff [--json] [package] [filename]: Shows the fields of [package] which differ from [filename]" << '\n';
+  cout << "diff [--json] --all [filename]: Shows the fields of all packages which differ from [filename]" << '\n';
+  cout << "\tFields are shown as \"::\"-delimited paths, with array elements written as [index]." << '\n';
+  cout << "\tUse [--json] to output the differences as a JSON Patch." << '\n';
+  cout << '\n';
+  cout << "udiff [context=3] [filename] [outfile=out.diff]: Writes a unified diff from [filename] to the currently loaded file." << '\n';
+  cout << "\tOnly packages whose contents differ are diffed, and hunks are grouped by package in sorted order." << '\n';
+  cout << "\tShow [context] unchanged lines around each change. Use '-' as [outfile] to write to standard output." << '\n';
+  cout << '\n';
+  cout << "store add [version] [filename]: Adds [filename] to the package store as [version]." << '\n';
+  cout << "\tIf [filename] is not given, the currently loaded file is added." << '\n';
+  cout << "store list: Lists all versions in the package store." << '\n';
+  cout << "store history [package]: Shows the versions where [package] is added, modified or removed." << '\n';
+  cout << "store compare [version]...: Compares the headers and contents between consecutive [version]s." << '\n';
+  cout << "\tThe package store must be selected with --store=[DIR] when launching." << '\n';
+  cout << '\n';
+  cout << "reload [filename]: Reloads the prettify replacement pairs from [filename]." << '\n';
+  cout << "\tIf [filename] is not specified, the current prettify file or the built-in tables are read again." << '\n';
+  cout << '\n';
+  cout << "stats [--memory]: Shows runtime statistics, such as prettify memo table hits and misses." << '\n';
+  cout << "\tIf --memory is specified, also shows the heap allocations of each operation. Requires --track-allocations."
+       << '\n';
+  cout << '\n';
   cout << "json-dump [--filename=out.json] [count=1024]: Reformat and dumps the currently loaded file into JSON format." << '\n';
   cout << "\tShow progress every [count] headers dumped." << '\n';
   cout << "\tSorted file will be dumped to [filename]." << '\n';
@@ -110,7 +167,9 @@ void Gui::Find(std::string args, bool is_interactive) const {
   enum class SearchMode {
     kDefault,
     kFront,
-    kLine
+    kFuzzy,
+    kLine,
+    kLineBatch
   };
 
   std::vector<std::string> argv = SplitString(std::move(args), " ");
@@ -118,10 +177,17 @@ void Gui::Find(std::string args, bool is_interactive) const {
   // initialize all parameters
   std::string find_s;
   unsigned int max_count = 50;
+  unsigned int top_count = 10;
   unsigned int line = 0;
+  std::string line_source;
   SearchMode mode = SearchMode::kDefault;
 
   for (auto&& arg : argv) {
+    // repeated spaces produce empty arguments
+    if (arg.empty()) {
+      continue;
+    }
+
     if (arg.substr(0, 6) == "count=") {
       try {
         max_count = static_cast<unsigned int>(std::stoul(arg.substr(6)));
@@ -129,6 +195,13 @@ void Gui::Find(std::string args, bool is_interactive) const {
         cerr << "Argument provided to [count] is not a number" << endl;
         return;
       }
+    } else if (arg.substr(0, 4) == "top=") {
+      try {
+        top_count = static_cast<unsigned int>(std::stoul(arg.substr(4)));
+      } catch (std::invalid_argument& ex_ia) {
+        cerr << "Argument provided to [top] is not a number" << endl;
+        return;
+      }
     } else if (arg.substr(0, 5) == "line="){
       try {
         line = static_cast<unsigned int>(std::stoul(arg.substr(5)));
@@ -137,14 +210,25 @@ void Gui::Find(std::string args, bool is_interactive) const {
         return;
       }
       mode = SearchMode::kLine;
+    } else if (arg.substr(0, 6) == "lines=") {
+      line_source = arg.substr(6);
+      mode = SearchMode::kLineBatch;
     } else if (arg == "-f") {
       mode = SearchMode::kFront;
+    } else if (arg.substr(0, 1) == "~") {
+      find_s = arg.substr(1);
+      mode = SearchMode::kFuzzy;
     } else {
       find_s = arg;
     }
   }
 
-  if (find_s.empty() && mode != SearchMode::kLine) {
+  if (mode == SearchMode::kLineBatch && line_source.empty()) {
+    cout << "No line number source provided." << endl;
+    return;
+  }
+
+  if (find_s.empty() && mode != SearchMode::kLine && mode != SearchMode::kLineBatch) {
     cout << "No search string provided." << endl;
     return;
   }
@@ -157,17 +241,34 @@ void Gui::Find(std::string args, bool is_interactive) const {
     case PackageVer::kCurrent:
       switch (mode) {
         case SearchMode::kDefault:
-          Log::i("Invoking Packages::Find(\"" + find_s + "\"...)");
+          LOG_I("Invoking Packages::Find(\"" + find_s + "\"...)");
           packages_->Find(std::move(find_s), false, max_count);
           break;
         case SearchMode::kFront:
-          Log::i("Invoking Packages::Find(\"" + find_s + "\"...)");
+          LOG_I("Invoking Packages::Find(\"" + find_s + "\"...)");
           packages_->Find(std::move(find_s), true, max_count);
           break;
+        case SearchMode::kFuzzy:
+          LOG_I("Invoking Packages::FuzzyFind(\"" + find_s + "\"...)");
+          packages_->FuzzyFind(std::move(find_s), top_count);
+          break;
         case SearchMode::kLine:
-          Log::i("Invoking Packages::ReverseLookup(" + std::to_string(line) + "...)");
+          LOG_I("Invoking Packages::ReverseLookup(" + std::to_string(line) + "...)");
           packages_->ReverseLookup(line, is_interactive);
           break;
+        case SearchMode::kLineBatch:
+          LOG_I("Invoking Packages::ReverseLookupBatch(\"" + line_source + "\")");
+          if (line_source == "-") {
+            packages_->ReverseLookupBatch(cin);
+          } else {
+            auto ifs = std::ifstream(line_source);
+            if (!ifs) {
+              cout << line_source << ": File not found." << endl;
+              break;
+            }
+            packages_->ReverseLookupBatch(ifs);
+          }
+          break;
         default:
           cout << "This mode is currently not supported with current packages." << endl;
           break;
@@ -179,6 +280,72 @@ void Gui::Find(std::string args, bool is_interactive) const {
   }
 }
 
+void Gui::Search(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  std::vector<std::string> terms;
+  bool rebuild = false;
+  for (auto&& arg : argv) {
+    if (arg == "--rebuild") {
+      rebuild = true;
+    } else if (!arg.empty()) {
+      terms.emplace_back(arg);
+    }
+  }
+
+  if (terms.empty()) {
+    cout << "No search terms provided." << endl;
+    return;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::Search(\"" + JoinToString(terms, " ") + "\"...)");
+      packages_->Search(std::move(terms), rebuild);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::Grep(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  // all arguments after the options form the pattern
+  bool is_regex = false;
+  bool show_lines = false;
+  auto it = argv.begin();
+  for (; it != argv.end(); ++it) {
+    if (*it == "--regex") {
+      is_regex = true;
+    } else if (*it == "--lines") {
+      show_lines = true;
+    } else {
+      break;
+    }
+  }
+  std::string pattern = JoinToString(std::vector<std::string>(it, argv.end()), " ");
+  if (!pattern.empty()) {
+    pattern.pop_back();
+  }
+
+  if (pattern.empty()) {
+    cout << "No pattern provided." << endl;
+    return;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::Grep(\"" + pattern + "\"...)");
+      packages_->Grep(pattern, is_regex, show_lines);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
 void Gui::View(const std::string args) const {
   enum class ViewMode {
     kDefault,
@@ -189,11 +356,14 @@ void Gui::View(const std::string args) const {
 
   // initialize all parameters
   std::string package;
+  std::string version;
   ViewMode mode = ViewMode::kDefault;
 
   for (auto&& arg : argv) {
     if (arg == "--raw") {
       mode = ViewMode::kRaw;
+    } else if (arg.substr(0, 10) == "--version=") {
+      version = arg.substr(10);
     } else {
       package = arg;
     }
@@ -204,15 +374,26 @@ void Gui::View(const std::string args) const {
     return;
   }
 
+  if (!version.empty()) {
+    if (store_ == nullptr) {
+      cout << "No package store is selected. Use --store=[DIR] when launching." << endl;
+      return;
+    }
+
+    LOG_I("Invoking Packages::OutputStoredHeader(\"" + version + "\", \"" + package + "\"...)");
+    packages_->OutputStoredHeader(*store_, version, package, mode == ViewMode::kRaw);
+    return;
+  }
+
   switch (package_ver_) {
     case PackageVer::kCurrent:
       switch (mode) {
         case ViewMode::kDefault:
-          Log::i("Invoking Packages::View(\"" + package + "\"...)");
+          LOG_I("Invoking Packages::View(\"" + package + "\"...)");
           packages_->OutputHeader(package, false);
           break;
         case ViewMode::kRaw:
-          Log::i("Invoking Packages::View(\"" + package + "\"...)");
+          LOG_I("Invoking Packages::View(\"" + package + "\"...)");
           packages_->OutputHeader(package, true);
           break;
         default:
@@ -226,6 +407,35 @@ void Gui::View(const std::string args) const {
   }
 }
 
+void Gui::Lines(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  if (argv.empty() || argv.size() > 2) {
+    cout << "Please supply a line range." << endl;
+    return;
+  }
+
+  unsigned int from{0};
+  unsigned int to{0};
+  try {
+    from = static_cast<unsigned int>(std::stoul(argv.at(0)));
+    to = argv.size() == 2 ? static_cast<unsigned int>(std::stoul(argv.at(1))) : from;
+  } catch (std::invalid_argument& ex_ia) {
+    cerr << "Argument provided to [from] or [to] is not a number" << endl;
+    return;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::OutputLines(" + std::to_string(from) + ", " + std::to_string(to) + ")");
+      packages_->OutputLines(from, to);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
 void Gui::Sort(const std::string args) const {
   std::vector<std::string> argv = SplitString(args, " ");
 
@@ -260,7 +470,7 @@ void Gui::Sort(const std::string args) const {
 
   switch (package_ver_) {
     case PackageVer::kCurrent:
-      Log::i("Invoking Packages::SortFile()");
+      LOG_I("Invoking Packages::SortFile()");
       packages_->SortFile(filename, format_opts, count);
       break;
     default:
@@ -284,7 +494,7 @@ void Gui::Compare(const std::string args) const {
 
   switch (package_ver_) {
     case PackageVer::kCurrent:
-      Log::i("Invoking Packages::Compare(\"" + filename + "\"...)");
+      LOG_I("Invoking Packages::Compare(\"" + filename + "\"...)");
       packages_->Compare(filename);
       break;
     default:
@@ -293,6 +503,187 @@ void Gui::Compare(const std::string args) const {
   }
 }
 
+void Gui::CompareMany(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  bool show_all = false;
+  auto filenames = std::vector<std::string>();
+  for (auto&& arg : argv) {
+    if (arg == "--all") {
+      show_all = true;
+    } else if (!arg.empty()) {
+      filenames.push_back(arg);
+    }
+  }
+
+  if (filenames.size() < 2) {
+    cout << "Please supply at least two filenames." << endl;
+    return;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::CompareMany(...)");
+      packages_->CompareMany(filenames, show_all);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::Diff(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  bool as_json = false;
+  bool is_all = false;
+  auto positional = std::vector<std::string>();
+  for (auto&& arg : argv) {
+    if (arg == "--json") {
+      as_json = true;
+    } else if (arg == "--all") {
+      is_all = true;
+    } else if (!arg.empty()) {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != (is_all ? 1 : 2)) {
+    cout << (is_all ? "Please supply a filename." : "Please supply a package and a filename.") << endl;
+    return;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      if (is_all) {
+        LOG_I("Invoking Packages::DiffAll(\"" + positional[0] + "\"...)");
+        packages_->DiffAll(positional[0], as_json);
+      } else {
+        LOG_I("Invoking Packages::Diff(\"" + positional[0] + "\", \"" + positional[1] + "\"...)");
+        packages_->Diff(positional[0], positional[1], as_json);
+      }
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::UnifiedDiff(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  unsigned context = 3;
+  auto positional = std::vector<std::string>();
+  for (auto&& arg : argv) {
+    if (arg.substr(0, 8) == "context=") {
+      try {
+        context = static_cast<unsigned>(std::stoul(arg.substr(8)));
+      } catch (std::invalid_argument& ex_ia) {
+        cerr << "Argument provided to [context] is not a number" << endl;
+        return;
+      }
+    } else if (!arg.empty()) {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.empty() || positional.size() > 2) {
+    cout << "Please supply a filename." << endl;
+    return;
+  }
+  const std::string outfile = positional.size() == 2 ? positional[1] : "out.diff";
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::UnifiedDiff(\"" + positional[0] + "\", \"" + outfile + "\"...)");
+      packages_->UnifiedDiff(positional[0], outfile, context);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::Store(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+  argv.erase(std::remove(argv.begin(), argv.end(), std::string()), argv.end());
+
+  if (store_ == nullptr) {
+    cout << "No package store is selected. Use --store=[DIR] when launching." << endl;
+    return;
+  }
+  if (argv.empty()) {
+    cout << "Please supply a store command." << endl;
+    return;
+  }
+
+  const std::string& command = argv[0];
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      if (command == "add" && (argv.size() == 2 || argv.size() == 3)) {
+        const std::string filename = argv.size() == 3 ? argv[2] : GetFileName();
+        LOG_I("Invoking Packages::StoreAdd(\"" + argv[1] + "\", \"" + filename + "\")");
+        packages_->StoreAdd(store_, argv[1], filename);
+      } else if (command == "list" && argv.size() == 1) {
+        LOG_I("Invoking Packages::StoreList()");
+        packages_->StoreList(*store_);
+      } else if (command == "history" && argv.size() == 2) {
+        LOG_I("Invoking Packages::StoreHistory(\"" + argv[1] + "\")");
+        packages_->StoreHistory(*store_, argv[1]);
+      } else if (command == "compare" && argv.size() >= 3) {
+        LOG_I("Invoking Packages::StoreCompare(...)");
+        packages_->StoreCompare(*store_, std::vector<std::string>(argv.begin() + 1, argv.end()));
+      } else {
+        cout << "Invalid store command. See help for usage." << endl;
+      }
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::Reload(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  std::string filename;
+  for (auto&& arg : argv) {
+    filename = arg;
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::ReloadPrettify(\"" + filename + "\")");
+      packages_->ReloadPrettify(filename);
+      cout << "Prettify replacement pairs reloaded." << endl;
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
+void Gui::Stats(const std::string args) const {
+  std::vector<std::string> argv = SplitString(args, " ");
+
+  bool is_memory = false;
+  for (auto&& arg : argv) {
+    if (arg == "--memory") {
+      is_memory = true;
+    }
+  }
+
+  switch (package_ver_) {
+    case PackageVer::kCurrent:
+      LOG_I("Invoking Packages::OutputStats()");
+      packages_->OutputStats(is_memory);
+      break;
+    default:
+      // all cases covered
+      break;
+  }
+}
+
 void Gui::JsonStructure(const std::string args) const {
   std::vector<std::string> argv = SplitString(args, " ");
 
@@ -313,7 +704,7 @@ void Gui::JsonStructure(const std::string args) const {
 
   switch (package_ver_) {
     case PackageVer::kCurrent:
-      Log::i("Invoking Packages::HeaderToJson(\"" + header + "\")");
+      LOG_I("Invoking Packages::HeaderToJson(\"" + header + "\")");
       packages_->HeaderToJson(header, opt, std::vector<std::string>());
       break;
     default:
@@ -350,7 +741,7 @@ void Gui::JsonDump(std::string&& args) const {
 
   switch (package_ver_) {
     case PackageVer::kCurrent:
-      Log::i("Invoking Packages::DumpJson()");
+      LOG_I("Invoking Packages::DumpJson()");
       packages_->DumpJson(std::move(filename), count);
       break;
     default:
@@ -10,6 +10,7 @@
 
 #include <memory>
 
+#include "package_store.h"
 #include "packages.h"
 
 class Gui {
@@ -22,22 +23,40 @@ class Gui {
     kExit,
     kHelp,
     kFind,
+    kSearch,
+    kGrep,
     kView,
+    kLines,
     kSort,
     kCompare,
+    kCompareMany,
+    kDiff,
+    kUnifiedDiff,
+    kStore,
+    kReload,
+    kStats,
     kDumpJson,
     kNoOpt
   };
 
-  explicit Gui(Packages* package);
+  explicit Gui(Packages* package, PackageStore* store = nullptr);
 
   void MainMenu();
 
   void Help(bool is_interactive) const;
   void Find(std::string args, bool is_interactive) const;
+  void Search(std::string args) const;
+  void Grep(std::string args) const;
   void View(std::string args) const;
+  void Lines(std::string args) const;
   void Sort(std::string args) const;
   void Compare(std::string args) const;
+  void CompareMany(std::string args) const;
+  void Diff(std::string args) const;
+  void UnifiedDiff(std::string args) const;
+  void Store(std::string args) const;
+  void Reload(std::string args) const;
+  void Stats(std::string args) const;
   void JsonStructure(const std::string args) const;
   void JsonDump(std::string&& args) const;
 
@@ -46,6 +65,7 @@ class Gui {
   auto GetSize() const -> std::size_t;
 
   Packages* packages_ = nullptr;
+  PackageStore* store_ = nullptr;
 
   PackageVer package_ver_ = PackageVer::kCurrent;
 };
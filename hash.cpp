@@ -0,0 +1,100 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for hashing utilities.
+//
+
+#include "hash.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+constexpr std::uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr std::uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr std::uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr std::uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr std::uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline auto RotateLeft(std::uint64_t x, unsigned r) -> std::uint64_t {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline auto Read64(const char* p) -> std::uint64_t {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline auto Read32(const char* p) -> std::uint32_t {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline auto Round(std::uint64_t acc, std::uint64_t input) -> std::uint64_t {
+  acc += input * kPrime2;
+  acc = RotateLeft(acc, 31);
+  return acc * kPrime1;
+}
+
+inline auto MergeRound(std::uint64_t acc, std::uint64_t val) -> std::uint64_t {
+  acc ^= Round(0, val);
+  return acc * kPrime1 + kPrime4;
+}
+}  // namespace
+
+auto XxHash64(const char* data, std::size_t length, std::uint64_t seed) -> std::uint64_t {
+  const char* p = data;
+  const char* const end = data + length;
+  std::uint64_t h;
+
+  if (length >= 32) {
+    std::uint64_t v1 = seed + kPrime1 + kPrime2;
+    std::uint64_t v2 = seed + kPrime2;
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - kPrime1;
+
+    // consume 32-byte stripes with four independent accumulators
+    for (; p + 32 <= end; p += 32) {
+      v1 = Round(v1, Read64(p));
+      v2 = Round(v2, Read64(p + 8));
+      v3 = Round(v3, Read64(p + 16));
+      v4 = Round(v4, Read64(p + 24));
+    }
+
+    h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    h = MergeRound(h, v1);
+    h = MergeRound(h, v2);
+    h = MergeRound(h, v3);
+    h = MergeRound(h, v4);
+  } else {
+    h = seed + kPrime5;
+  }
+
+  h += length;
+
+  // consume the remaining bytes
+  for (; p + 8 <= end; p += 8) {
+    h ^= Round(0, Read64(p));
+    h = RotateLeft(h, 27) * kPrime1 + kPrime4;
+  }
+  if (p + 4 <= end) {
+    h ^= std::uint64_t{Read32(p)} * kPrime1;
+    h = RotateLeft(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= std::uint64_t{static_cast<unsigned char>(*p)} * kPrime5;
+    h = RotateLeft(h, 11) * kPrime1;
+  }
+
+  // final avalanche
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+
+  return h;
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for non-cryptographic hashing.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_HASH_H_
+#define WARFRAME_PACKAGES_DEPARSER_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Computes the 64-bit xxHash (XXH64) of a buffer.
+ *
+ * @param data Start of the buffer
+ * @param length Length of the buffer in bytes
+ * @param seed Seed of the hash
+ * @return Hash of the buffer
+ */
+auto XxHash64(const char* data, std::size_t length, std::uint64_t seed = 0) -> std::uint64_t;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_HASH_H_
@@ -31,10 +31,19 @@ void OutputHelp(const std::string& s) {
   message += "  -D, --no-debug\t\tdisable logging\n";
   message += "  -f, --file=[FILE]\tread Packages.txt from [FILE]\n";
   message += "  -I, --no-interactive\tdisable interactive mode\n";
-  message += "  -p, --prettify=[FILE]\timport prettifying replacement pairs from [FILE]\n";
+  message += "      --log-level=[LEVEL]\tonly log messages of at least [LEVEL] (verbose, debug, info, warning, error)\n";
+  message += "  -p, --prettify=[FILE]\timport prettifying replacement pairs from [FILE] instead of the built-in ones\n";
+  message += "      --profile\t\tprint a profile of all operations to stderr at exit\n";
+  message += "      --profile-counters\talso count hardware events (cycles, cache misses, etc.) in the profile\n";
+  message += "      --trace=[FILE]\twrite a trace of all operations to [FILE] in Chrome trace event format\n";
+  message += "      --track-allocations\trecord heap allocations of all operations, see \'stats --memory\'\n";
+  message += "      --store=[DIR]\tuse the package store in [DIR], creating it if needed\n";
+  message += "      --script=[FILE]\trun each line of [FILE] as a command and exit. Use \'-\' to read from standard input\n";
   message += "      --help\t\tdisplay this help and exit\n";
   message += "      --version\t\toutput version information and exit\n\n";
   message += "MODE and MODE_ARGS will only be parsed if \'--no-interactive\' is provided.\n";
+  message += "The output of each command of a script is enclosed in \'### BEGIN [N] [COMMAND]\' and \'### END [N] [STATUS]\' lines.\n";
+  message += "[STATUS] is ok, not-found or error. The exit status is 1 if any command does not succeed.\n";
   message += "For help on using interactive mode, provide \'help\' to MODE.\n";
 
   std::cout << message << std::endl;
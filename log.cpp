@@ -6,17 +6,29 @@
 
 #include "log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using std::cerr;
 using std::clog;
 using std::string;
 
 bool Log::is_init_ = false;
-bool Log::enable_logging_ = false;
+std::atomic<bool> Log::enable_logging_{false};
+Log::Level Log::min_level_ = Log::kVerbose;
 bool Log::use_override_pipe_ = false;
 Log::Pipe Log::override_pipe_ = Log::Pipe::kDefault;
 
@@ -27,16 +39,147 @@ std::unique_ptr<std::string> Log::warn_app_ = nullptr;
 std::unique_ptr<std::string> Log::error_app_ = nullptr;
 
 std::unique_ptr<std::size_t> Log::padding_len_ = nullptr;
+std::array<std::string, Log::kError + 1> Log::padded_tags_;
 
 std::unique_ptr<std::ofstream> Log::log_str_ = nullptr;
+std::atomic<bool> Log::is_file_open_{false};
+
+std::mutex Log::mutex_;
 
 namespace {
-void PutTime(std::stringstream& ss) {
-  auto time = std::time(nullptr);
+/**
+ * @brief Maximum number of records waiting to be written.
+ */
+constexpr std::size_t kQueueCapacity = 4096;
+
+/**
+ * @brief A message waiting to be written by the writer thread.
+ */
+struct Record {
+  /**
+   * @brief Whether this record is a request to flush, instead of a message.
+   */
+  bool is_flush;
+  /**
+   * @brief Ticket of the flush request, for the requesting thread to wait on.
+   */
+  std::uint64_t flush_ticket;
+  std::time_t time;
+  Log::Level level;
+  Log::Pipe dest;
+  std::string message;
+};
+
+/**
+ * Bounded lock-free queue with multiple producers and a single consumer.
+ *
+ * Each slot carries a sequence number, which tells producers whether the slot is free for the current lap of the
+ * ring, and tells the consumer whether the slot has been filled.
+ */
+class RecordQueue {
+ public:
+  RecordQueue() : slots_(kQueueCapacity) {
+    for (std::size_t i = 0; i < kQueueCapacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Adds a record to the queue.
+   *
+   * @param record Record to add
+   * @return True if successful, false if the queue is full
+   */
+  bool TryPush(Record* const record) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[pos % kQueueCapacity];
+      const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot.record = std::move(*record);
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Removes the oldest record from the queue. Must only be called by the consumer.
+   *
+   * @param record Removed record
+   * @return True if successful, false if the queue is empty
+   */
+  bool TryPop(Record* const record) {
+    Slot& slot = slots_[head_ % kQueueCapacity];
+    if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+      return false;
+    }
+
+    *record = std::move(slot.record);
+    slot.sequence.store(head_ + kQueueCapacity, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence{0};
+    Record record;
+  };
+
+  std::vector<Slot> slots_;
+  std::atomic<std::size_t> tail_{0};
+  /**
+   * @brief Position of the next record to pop. Only accessed by the consumer.
+   */
+  std::size_t head_ = 0;
+};
+
+/**
+ * @brief Maximum number of records written by the writer thread at a time.
+ */
+constexpr std::size_t kWriteBatchSize = 256;
+
+std::unique_ptr<RecordQueue> record_queue = nullptr;
+std::thread writer_thread;
+std::atomic<bool> is_writer_running{false};
+std::atomic<bool> is_writer_stopping{false};
+
+/**
+ * @brief Whether the writer thread is waiting for records, so that producers know to wake it up.
+ */
+std::atomic<bool> is_writer_idle{false};
+std::mutex writer_mutex;
+std::condition_variable writer_cv;
+
+/**
+ * @brief Ticket of the latest flush request, and of the latest flush request completed by the writer thread.
+ */
+std::atomic<std::uint64_t> flush_requested{0};
+std::uint64_t flush_completed = 0;
+std::condition_variable flush_cv;
+
+void PutTime(std::stringstream& ss, std::time_t time) {
   std::tm tm = *std::localtime(&time);
 
   ss << std::put_time(&tm, "%m-%d %H:%M:%S");
 }
+
+/**
+ * @brief Wakes up the writer thread if it is waiting for records.
+ */
+void WakeWriter() {
+  if (is_writer_idle.load()) {
+    writer_cv.notify_one();
+  }
+}
 }  // namespace
 
 void Log::Init() {
@@ -51,6 +194,41 @@ void Log::Init() {
   EvaluatePadding();
 
   is_init_ = true;
+
+  if (!is_writer_running.load()) {
+    record_queue = std::make_unique<RecordQueue>();
+    is_writer_stopping.store(false);
+    writer_thread = std::thread(&Log::RunWriter);
+    is_writer_running.store(true);
+    std::atexit(&Log::Shutdown);
+  }
+}
+
+void Log::Shutdown() {
+  if (!is_writer_running.load()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    is_writer_stopping.store(true);
+  }
+  writer_cv.notify_one();
+  writer_thread.join();
+  is_writer_running.store(false);
+
+  // write any records pushed while the writer thread is stopping
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record record;
+  while (record_queue->TryPop(&record)) {
+    if (!record.is_flush) {
+      Write(record.time, record.level, record.dest, record.message);
+    }
+  }
+  if (log_str_ != nullptr) {
+    log_str_->flush();
+  }
+  clog.flush();
 }
 
 void Log::Enable() {
@@ -58,7 +236,7 @@ void Log::Enable() {
     throw std::runtime_error("Logging class has not been initialized yet");
   }
 
-  enable_logging_ = true;
+  enable_logging_.store(true);
 }
 
 void Log::Disable() {
@@ -66,28 +244,36 @@ void Log::Disable() {
     throw std::runtime_error("Logging class has not been initialized yet");
   }
 
-  enable_logging_ = false;
+  enable_logging_.store(false);
 }
 
 bool Log::SetFile(string filename, std::ios_base::openmode mode) {
   if (!enable_logging_) return false;
 
+  WaitForWriter(false);
+  std::lock_guard<std::mutex> lock(mutex_);
+
   if (log_str_ != nullptr) {
     log_str_->close();
   }
 
   log_str_ = std::make_unique<std::ofstream>(filename, mode);
-  return static_cast<bool>(*log_str_);
+  is_file_open_.store(static_cast<bool>(*log_str_));
+  return is_file_open_.load();
 }
 
 bool Log::ForceSetFile(string filename, std::ios_base::openmode mode) {
   if (!enable_logging_) return false;
 
+  WaitForWriter(false);
+  std::lock_guard<std::mutex> lock(mutex_);
+
   if (log_str_ != nullptr) {
     log_str_->close();
   }
 
   log_str_ = std::make_unique<std::ofstream>(filename, mode);
+  is_file_open_.store(static_cast<bool>(*log_str_));
   if (!*log_str_) {
     throw std::ios_base::failure("Unable to open file for write");
   }
@@ -96,168 +282,250 @@ bool Log::ForceSetFile(string filename, std::ios_base::openmode mode) {
 }
 
 void Log::v(string message, Pipe dest) {
-  if (!enable_logging_) return;
+  if (!IsEnabled(kVerbose)) return;
 
-  std::stringstream ss;
-  PutTime(ss);
-  ss <<  '\t' << *verbose_app_ << GetPadding(kVerbose) << ": " << message << '\n';
+  Enqueue(kVerbose, std::move(message), dest);
+}
 
-  if (use_override_pipe_) {
-    dest = override_pipe_;
-  }
+void Log::d(string message, Pipe dest) {
+  if (!IsEnabled(kDebug)) return;
 
-  switch (dest) {
-    default:
-    case Pipe::kDefault:
-    case Pipe::kClog:
-      clog << ss.str();
-      break;
-    case Pipe::kFile: {
-      if (!*log_str_) {
-        throw std::runtime_error("No file open for logging");
-      }
-      *log_str_ << ss.str();
-    }
-  }
+  Enqueue(kDebug, std::move(message), dest);
 }
 
-void Log::d(string message, Pipe dest) {
-  if (!enable_logging_) return;
+void Log::i(string message, Pipe dest) {
+  if (!IsEnabled(kInfo)) return;
 
-  std::stringstream ss;
-  PutTime(ss);
-  ss << '\t' << *debug_app_ << GetPadding(kDebug) << ": " << message << '\n';
+  Enqueue(kInfo, std::move(message), dest);
+}
 
-  if (use_override_pipe_) {
-    dest = override_pipe_;
-  }
+void Log::w(string message, Pipe dest) {
+  if (!IsEnabled(kWarn)) return;
 
-  switch (dest) {
-    default:
-    case Pipe::kDefault:
-    case Pipe::kClog:
-      clog << ss.str();
-      break;
-    case Pipe::kFile: {
-      if (!log_str_) {
-        throw std::runtime_error("No file open for logging");
-      }
-      *log_str_ << ss.str();
-    }
+  Enqueue(kWarn, std::move(message), dest);
+}
+
+void Log::e(string message, Pipe dest) {
+  if (!IsEnabled(kError)) return;
+
+  Enqueue(kError, std::move(message), dest);
+
+  // errors are written immediately, in case the application is about to terminate
+  WaitForWriter(true);
+}
+
+bool Log::ParseLevel(const std::string& name, Level* const lvl) {
+  if (name == "verbose") {
+    *lvl = kVerbose;
+  } else if (name == "debug") {
+    *lvl = kDebug;
+  } else if (name == "info") {
+    *lvl = kInfo;
+  } else if (name == "warning") {
+    *lvl = kWarn;
+  } else if (name == "error") {
+    *lvl = kError;
+  } else {
+    return false;
   }
+  return true;
 }
 
-void Log::i(string message, Pipe dest) {
-  if (!enable_logging_) return;
+void Log::FlushStderrBuf() {
+  clog.flush();
+}
 
-  std::stringstream ss;
-  PutTime(ss);
-  ss << '\t' << *info_app_ << GetPadding(kInfo) << ": " << message << '\n';
+void Log::FlushFileBuf() {
+  WaitForWriter(true);
 
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (log_str_ != nullptr) {
+    log_str_->flush();
+  }
+}
+
+/**
+ * @brief Passes a message to the writer thread.
+ *
+ * If the writer thread is not running, the message is written synchronously instead.
+ *
+ * @param lvl Level of the message
+ * @param message Message contents
+ * @param dest Destination to pipe to
+ */
+void Log::Enqueue(Level lvl, std::string&& message, Pipe dest) {
   if (use_override_pipe_) {
     dest = override_pipe_;
   }
+  // the stream itself is only accessed while holding mutex_, as another thread may replace it
+  if (dest == Pipe::kFile && !is_file_open_.load()) {
+    throw std::runtime_error("No file open for logging");
+  }
 
-  switch (dest) {
-    default:
-    case Pipe::kDefault:
-    case Pipe::kClog:
-      clog << ss.str();
-      break;
-    case Pipe::kFile: {
-      if (!*log_str_) {
-        throw std::runtime_error("No file open for logging");
-      }
-      *log_str_ << ss.str();
-    }
+  const std::time_t time = std::time(nullptr);
+  if (!is_writer_running.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Write(time, lvl, dest, message);
+    return;
   }
-}
 
-void Log::w(string message, Pipe dest) {
-  if (!enable_logging_) return;
+  Record record{false, 0, time, lvl, dest, std::move(message)};
+  while (!record_queue->TryPush(&record)) {
+    // the queue is full, so wait for the writer thread to catch up
+    WakeWriter();
+    std::this_thread::yield();
+  }
+  WakeWriter();
+}
 
-  std::stringstream ss;
-  PutTime(ss);
-  ss << '\t' << *warn_app_ << GetPadding(kWarn) << ": " << message << '\n';
+/**
+ * @brief Waits until all messages logged before the call are written by the writer thread.
+ *
+ * @param is_flush Whether to also flush the output streams
+ */
+void Log::WaitForWriter(bool is_flush) {
+  if (!is_writer_running.load(std::memory_order_acquire)) {
+    return;
+  }
 
-  if (use_override_pipe_) {
-    dest = override_pipe_;
+  const std::uint64_t ticket = flush_requested.fetch_add(1) + 1;
+  Record record{true, ticket, 0, kInfo, is_flush ? kFile : kDefault, std::string()};
+  while (!record_queue->TryPush(&record)) {
+    WakeWriter();
+    std::this_thread::yield();
   }
 
-  switch (dest) {
-    default:
-    case Pipe::kDefault:
-    case Pipe::kClog:
-      clog << ss.str();
-      break;
-    case Pipe::kFile: {
-      if (!*log_str_) {
-        throw std::runtime_error("No file open for logging");
+  std::unique_lock<std::mutex> lock(writer_mutex);
+  writer_cv.notify_one();
+  flush_cv.wait(lock, [ticket] { return flush_completed >= ticket; });
+}
+
+/**
+ * @brief Main function of the writer thread.
+ *
+ * Records are taken from the queue in batches, and written while holding the output stream lock once per batch.
+ */
+void Log::RunWriter() {
+  auto batch = std::vector<Record>(kWriteBatchSize);
+  for (;;) {
+    std::size_t count = 0;
+    while (count < kWriteBatchSize && record_queue->TryPop(&batch[count])) {
+      ++count;
+    }
+
+    if (count == 0) {
+      std::unique_lock<std::mutex> lock(writer_mutex);
+      if (is_writer_stopping.load()) {
+        return;
+      }
+
+      // check the queue again after announcing that the writer is idle, so that a record pushed in between is not
+      // missed; the timeout bounds the delay if a wake-up is lost
+      is_writer_idle.store(true);
+      Record record;
+      if (record_queue->TryPop(&record)) {
+        is_writer_idle.store(false);
+        batch[0] = std::move(record);
+        count = 1;
+      } else {
+        writer_cv.wait_for(lock, std::chrono::milliseconds(50));
+        is_writer_idle.store(false);
+        continue;
       }
-      *log_str_ << ss.str();
     }
-  }
-}
 
-void Log::e(string message, Pipe dest) {
-  if (!enable_logging_) return;
+    bool is_flush = false;
+    std::uint64_t flush_ticket = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (std::size_t i = 0; i < count; ++i) {
+        Record& record = batch[i];
+        if (record.is_flush) {
+          is_flush = is_flush || record.dest == kFile;
+          flush_ticket = std::max(flush_ticket, record.flush_ticket);
+          continue;
+        }
+
+        is_flush = is_flush || record.level == kError;
+        Write(record.time, record.level, record.dest, record.message);
+        record.message = std::string();
+      }
 
-  std::stringstream ss;
-  PutTime(ss);
-  ss << '\t' << *error_app_ << GetPadding(kError) << ": " << message << '\n';
+      if (is_flush) {
+        if (log_str_ != nullptr) {
+          log_str_->flush();
+        }
+        clog.flush();
+      }
+    }
 
-  if (use_override_pipe_) {
-    dest = override_pipe_;
+    if (flush_ticket != 0) {
+      std::lock_guard<std::mutex> lock(writer_mutex);
+      flush_completed = std::max(flush_completed, flush_ticket);
+      flush_cv.notify_all();
+    }
   }
+}
+
+/**
+ * @brief Formats and writes a message. Must be called while holding @c mutex_.
+ *
+ * @param time Time when the message is logged
+ * @param lvl Level of the message
+ * @param dest Destination to pipe to
+ * @param message Message contents
+ */
+void Log::Write(std::time_t time, Level lvl, Pipe dest, const std::string& message) {
+  std::stringstream ss;
+  PutTime(ss, time);
+  ss << '\t' << padded_tags_[lvl] << ": " << message << '\n';
 
   switch (dest) {
     default:
     case Pipe::kDefault:
-      cerr << ss.str();
+      if (lvl == kError) {
+        cerr << ss.str();
+      } else {
+        clog << ss.str();
+      }
       break;
     case Pipe::kClog:
       clog << ss.str();
       break;
-    case Pipe::kFile: {
-      if (!*log_str_) {
-        throw std::runtime_error("No file open for logging");
+    case Pipe::kFile:
+      if (log_str_ != nullptr) {
+        *log_str_ << ss.str();
       }
-      *log_str_ << ss.str();
-    }
-  }
-}
-
-void Log::FlushStderrBuf() {
-  clog.flush();
-}
-
-void Log::FlushFileBuf() {
-  if (log_str_ != nullptr) {
-    log_str_->flush();
+      break;
   }
 }
 
 void Log::SetVerboseString(string str) {
+  std::lock_guard<std::mutex> lock(mutex_);
   *verbose_app_ = std::move(str);
   EvaluatePadding();
 }
 
 void Log::SetDebugString(string str) {
+  std::lock_guard<std::mutex> lock(mutex_);
   *debug_app_ = std::move(str);
   EvaluatePadding();
 }
 
 void Log::SetInfoString(string str) {
+  std::lock_guard<std::mutex> lock(mutex_);
   *info_app_ = std::move(str);
   EvaluatePadding();
 }
 
 void Log::SetWarningString(string str) {
+  std::lock_guard<std::mutex> lock(mutex_);
   *warn_app_ = std::move(str);
   EvaluatePadding();
 }
 
 void Log::SetErrorString(string str) {
+  std::lock_guard<std::mutex> lock(mutex_);
   *error_app_ = std::move(str);
   EvaluatePadding();
 }
@@ -268,6 +536,12 @@ void Log::EvaluatePadding() {
   *padding_len_ = std::max(*padding_len_, info_app_->length());
   *padding_len_ = std::max(*padding_len_, warn_app_->length());
   *padding_len_ = std::max(*padding_len_, error_app_->length());
+
+  padded_tags_[kVerbose] = *verbose_app_ + GetPadding(kVerbose);
+  padded_tags_[kDebug] = *debug_app_ + GetPadding(kDebug);
+  padded_tags_[kInfo] = *info_app_ + GetPadding(kInfo);
+  padded_tags_[kWarn] = *warn_app_ + GetPadding(kWarn);
+  padded_tags_[kError] = *error_app_ + GetPadding(kError);
 }
 
 auto Log::GetPadding(Level lvl) -> std::string {
@@ -7,10 +7,29 @@
 #ifndef WARFRAME_PACKAGES_DEPARSER_STATIC_LOG_H_
 #define WARFRAME_PACKAGES_DEPARSER_STATIC_LOG_H_
 
+#include <array>
+#include <atomic>
+#include <ctime>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
 
+/**
+ * Minimum level of messages which are compiled in. Messages below this level are removed at compile time when logged
+ * through the @c LOG_* macros.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif  // LOG_MIN_LEVEL
+
+/**
+ * Static logging class.
+ *
+ * Messages are passed to a background writer thread through a lock-free queue, so that logging from hot paths and
+ * worker threads only costs a string move. The writer thread formats and writes messages in batches. Messages are
+ * flushed when @c FlushFileBuf is called, when an error is logged, and when the application exits.
+ */
 class Log {
  public:
   /**
@@ -50,11 +69,17 @@ class Log {
   ~Log() = delete;
 
   /**
-   * Initializes all fields in this class.
+   * Initializes all fields in this class, and starts the writer thread.
    *
    * @note This function must be called before any other methods are used.
    */
   static void Init();
+  /**
+   * Writes all pending messages and stops the writer thread. Messages logged afterwards are written synchronously.
+   *
+   * @note This function is registered to be called at exit by @c Init.
+   */
+  static void Shutdown();
 
   /**
    * Enable all logging functions provided by this class.
@@ -69,6 +94,32 @@ class Log {
    */
   static void Disable();
 
+  /**
+   * Sets the minimum level of messages to log.
+   *
+   * @param lvl Minimum level
+   */
+  static void SetLevel(Level lvl) { min_level_ = lvl; }
+  /**
+   * Parses the name of a level.
+   *
+   * @param name Name of the level, such as "debug"
+   * @param lvl Parsed level
+   *
+   * @return True if successful
+   */
+  static bool ParseLevel(const std::string& name, Level* lvl);
+  /**
+   * Checks whether messages of a level are logged.
+   *
+   * @param lvl Level of the message
+   *
+   * @return True if logging is enabled and the level is not below the minimum level
+   */
+  static auto IsEnabled(Level lvl) -> bool {
+    return enable_logging_.load(std::memory_order_relaxed) && lvl >= min_level_;
+  }
+
   /**
    * Sets the output file for logging.
    *
@@ -153,7 +204,7 @@ class Log {
    */
   static void FlushStderrBuf();
   /**
-   * Flushes the file buffer.
+   * Flushes the file buffer, after all messages logged before the call are written.
    */
   static void FlushFileBuf();
 
@@ -189,11 +240,17 @@ class Log {
   static void SetErrorString(std::string str);
 
  private:
+  static void Enqueue(Level lvl, std::string&& message, Pipe dest);
+  static void RunWriter();
+  static void Write(std::time_t time, Level lvl, Pipe dest, const std::string& message);
+  static void WaitForWriter(bool is_flush);
+
   static void EvaluatePadding();
   static auto GetPadding(Level lvl) -> std::string;
 
   static bool is_init_;
-  static bool enable_logging_;
+  static std::atomic<bool> enable_logging_;
+  static Level min_level_;
 
   static bool use_override_pipe_;
   static Pipe override_pipe_;
@@ -205,8 +262,38 @@ class Log {
   static std::unique_ptr<std::string> error_app_;
 
   static std::unique_ptr<std::size_t> padding_len_;
+  /**
+   * @brief Tags of each level, padded to the same length.
+   */
+  static std::array<std::string, kError + 1> padded_tags_;
 
   static std::unique_ptr<std::ofstream> log_str_;
+  /**
+   * @brief Whether @c log_str_ is open, so that callers can check it without holding @c mutex_.
+   */
+  static std::atomic<bool> is_file_open_;
+
+  /**
+   * @brief Serializes access to the output streams and tags between the writer thread and other threads.
+   */
+  static std::mutex mutex_;
 };
 
+/**
+ * Logs a message if its level is enabled. The message arguments are only evaluated if the message is logged, and the
+ * whole statement is removed at compile time if the level is below @c LOG_MIN_LEVEL.
+ */
+#define LOG_AT_LEVEL(lvl, fn, ...)                                       \
+  do {                                                                   \
+    if (static_cast<int>(lvl) >= LOG_MIN_LEVEL && Log::IsEnabled(lvl)) { \
+      Log::fn(__VA_ARGS__);                                              \
+    }                                                                    \
+  } while (false)
+
+#define LOG_V(...) LOG_AT_LEVEL(Log::kVerbose, v, __VA_ARGS__)
+#define LOG_D(...) LOG_AT_LEVEL(Log::kDebug, d, __VA_ARGS__)
+#define LOG_I(...) LOG_AT_LEVEL(Log::kInfo, i, __VA_ARGS__)
+#define LOG_W(...) LOG_AT_LEVEL(Log::kWarn, w, __VA_ARGS__)
+#define LOG_E(...) LOG_AT_LEVEL(Log::kError, e, __VA_ARGS__)
+
 #endif  // WARFRAME_PACKAGES_DEPARSER_STATIC_LOG_H_
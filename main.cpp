@@ -4,8 +4,10 @@
 // This file parses the program argument, and inflates the Gui class.
 //
 
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <istream>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -14,7 +16,9 @@
 #include "cui.h"
 #include "gui.h"
 #include "init.h"
+#include "package_store.h"
 #include "packages.h"
+#include "profiler.h"
 #include "log.h"
 #include "util.h"
 
@@ -29,12 +33,16 @@ struct {
   Gui::PackageVer package_ver = Gui::PackageVer::kCurrent;
 
   std::string prettify_src = "";
+  std::string store_dir = "";
+  std::string script_src = "";
 
   bool is_interactive = true;
   std::vector<std::string> ni_args;
 } program_args;
 
 void ReadArgs(const std::vector<std::string>& args, std::string* filename);
+void AddCommands(Cui* c, const Gui& g);
+auto RunScript(Cui* c, std::istream& is) -> bool;
 
 /**
  * @brief Parse all arguments in the command line.
@@ -73,6 +81,34 @@ void ReadArgs(const std::vector<std::string>& args, std::string* const filename)
       program_args.prettify_src = *++it;
     } else if (it->substr(0, 11) == "--prettify=") {
       program_args.prettify_src = it->substr(11);
+    } else if (*it == "--profile") {
+      Profiler::Enable();
+    } else if (*it == "--profile-counters") {
+      try {
+        Profiler::EnableCounters();
+      } catch (std::runtime_error& ex_runtime) {
+        cout << "Warning: " << ex_runtime.what() << ". Profiling without them." << endl;
+        Profiler::Enable();
+      }
+    } else if (*it == "--track-allocations") {
+      try {
+        Profiler::EnableAllocationTracking();
+      } catch (std::runtime_error& ex_runtime) {
+        cout << "Warning: " << ex_runtime.what() << endl;
+      }
+    } else if (it->substr(0, 8) == "--trace=") {
+      Profiler::EnableTrace(it->substr(8));
+    } else if (it->substr(0, 12) == "--log-level=") {
+      Log::Level level;
+      if (Log::ParseLevel(it->substr(12), &level)) {
+        Log::SetLevel(level);
+      } else {
+        cout << "Warning: Unrecognized log level " << it->substr(12) << endl;
+      }
+    } else if (it->substr(0, 8) == "--store=") {
+      program_args.store_dir = it->substr(8);
+    } else if (it->substr(0, 9) == "--script=") {
+      program_args.script_src = it->substr(9);
     } else if (!program_args.is_interactive && is_parse_ni_args) {
       program_args.ni_args.push_back(*it);
     } else if (*it == "--") {
@@ -92,17 +128,98 @@ void ReadArgs(const std::vector<std::string>& args, std::string* const filename)
   Log::SetOverridePipe(Log::kFile);
   Log::UseOverridePipe(true);
 
-  Log::d("Launching with arguments: ");
+  LOG_D("Launching with arguments: ");
   for (std::size_t it = 0; it < args.size(); ++it) {
-    Log::d("[" + std::to_string(it) + "] " + args[it]);
+    LOG_D("[" + std::to_string(it) + "] " + args[it]);
   }
-  Log::d("Interpreting Package Version: " + std::to_string(static_cast<int>(program_args.package_ver)));
-  Log::d(
-      "Prettify Replacement Source: " + (program_args.prettify_src.empty() ? "(none)" : program_args.prettify_src));
-  Log::d("Interactive Mode: " + std::string(program_args.is_interactive ? "true" : "false"));
-  Log::d("Interactive Mode Arguments: " + JoinToString(program_args.ni_args, " "));
+  LOG_D("Interpreting Package Version: " + std::to_string(static_cast<int>(program_args.package_ver)));
+  LOG_D(
+      "Prettify Replacement Source: " + (program_args.prettify_src.empty() ? "(built-in)" : program_args.prettify_src));
+  LOG_D("Package Store: " + (program_args.store_dir.empty() ? "(none)" : program_args.store_dir));
+  LOG_D("Script: " + (program_args.script_src.empty() ? "(none)" : program_args.script_src));
+  LOG_D("Interactive Mode: " + std::string(program_args.is_interactive ? "true" : "false"));
+  LOG_D("Interactive Mode Arguments: " + JoinToString(program_args.ni_args, " "));
   Log::FlushFileBuf();
 }
+
+/**
+ * @brief Adds all commands which can be run without user interaction.
+ *
+ * @param c Console interface to add the commands to
+ * @param g Gui to run the commands with
+ */
+void AddCommands(Cui* const c, const Gui& g) {
+  c->AddItem("Find", "find", std::bind(&Gui::Find, g, std::placeholders::_1, false));
+  c->AddItem("Search", "search", std::bind(&Gui::Search, g, std::placeholders::_1));
+  c->AddItem("Grep", "grep", std::bind(&Gui::Grep, g, std::placeholders::_1));
+  c->AddItem("View", "view", std::bind(&Gui::View, g, std::placeholders::_1));
+  c->AddItem("Lines", "lines", std::bind(&Gui::Lines, g, std::placeholders::_1));
+  c->AddItem("Sort", "sort", std::bind(&Gui::Sort, g, std::placeholders::_1));
+  c->AddItem("Compare", "compare", std::bind(&Gui::Compare, g, std::placeholders::_1));
+  c->AddItem("Compare Many", "compare-many", std::bind(&Gui::CompareMany, g, std::placeholders::_1));
+  c->AddItem("Diff", "diff", std::bind(&Gui::Diff, g, std::placeholders::_1));
+  c->AddItem("Unified Diff", "udiff", std::bind(&Gui::UnifiedDiff, g, std::placeholders::_1));
+  c->AddItem("Store", "store", std::bind(&Gui::Store, g, std::placeholders::_1));
+  c->AddItem("Reload", "reload", std::bind(&Gui::Reload, g, std::placeholders::_1));
+  c->AddItem("Stats", "stats", std::bind(&Gui::Stats, g, std::placeholders::_1));
+  c->AddItem("json-struct", "json-struct", std::bind(&Gui::JsonStructure, g, std::placeholders::_1));
+  c->AddItem("json-dump", "json-dump", std::bind(&Gui::JsonDump, g, std::placeholders::_1));
+  c->AddItem("Help", "help", std::bind(&Gui::Help, g, false));
+}
+
+/**
+ * @brief Runs every line of a script as a command.
+ *
+ * The output of each command is enclosed in a "### BEGIN" and a "### END" line, which carry the number of the command
+ * and, respectively, the command itself and its status: "ok", "not-found" if it is not recognized, or "error" if it
+ * throws. Empty lines and lines starting with '#' are skipped, and the script stops at an "exit" line.
+ *
+ * @param c Console interface to run the commands with
+ * @param is Input stream of the script
+ * @return True if all commands are recognized and succeed
+ */
+auto RunScript(Cui* const c, std::istream& is) -> bool {
+  bool is_all_ok = true;
+  unsigned count = 0;
+
+  std::string line;
+  while (getline(is, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    line.erase(0, line.find_first_not_of(" \t"));
+
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    if (line == "exit") {
+      break;
+    }
+
+    ++count;
+    LOG_D("Running script command " + std::to_string(count) + ": " + line);
+    cout << "### BEGIN " << count << " " << line << endl;
+
+    // a failing command must not abort the rest of the script
+    std::string status = "ok";
+    try {
+      if (c->Parse(line) == Cui::ParseResult::kCmdNotFound) {
+        cout << line << ": Not found" << endl;
+        status = "not-found";
+      }
+    } catch (std::exception& ex) {
+      LOG_E("Script command " + std::to_string(count) + " failed: " + ex.what());
+      cout << "Error: " << ex.what() << endl;
+      status = "error";
+    }
+    is_all_ok = is_all_ok && status == "ok";
+
+    cout << "### END " << count << " " << status << endl;
+    Log::FlushFileBuf();
+  }
+
+  return is_all_ok;
+}
 }  // namespace
 
 auto main(int argc, char* argv[]) -> int {
@@ -120,12 +237,12 @@ auto main(int argc, char* argv[]) -> int {
   try {
     switch (program_args.package_ver) {
       case Gui::PackageVer::kCurrent:
-        Log::v("Attempting to create Packages");
+        LOG_V("Attempting to create Packages");
         package = std::make_unique<Packages>(filename, std::move(file_stream), std::move(program_args.prettify_src));
         break;
     }
   } catch (std::runtime_error& ex_runtime) {
-    Log::e("Error while opening file: " + std::string(ex_runtime.what()));
+    LOG_E("Error while opening file: " + std::string(ex_runtime.what()));
     cout << "Error while opening file: " << ex_runtime.what() << endl;
     return 0;
   }
@@ -137,31 +254,54 @@ auto main(int argc, char* argv[]) -> int {
     return 1;
   }
 
-  Log::v("Invoking Gui::Gui(Packages)");
-  Gui g(package.get());
+  std::unique_ptr<PackageStore> store = nullptr;
+  if (!program_args.store_dir.empty()) {
+    try {
+      store = std::make_unique<PackageStore>(program_args.store_dir);
+    } catch (std::runtime_error& ex_runtime) {
+      LOG_E("Error while opening package store: " + std::string(ex_runtime.what()));
+      cout << "Error while opening package store: " << ex_runtime.what() << endl;
+      return 0;
+    }
+  }
+
+  LOG_V("Invoking Gui::Gui(Packages)");
+  Gui g(package.get(), store.get());
   Log::FlushFileBuf();
 
-  if (!program_args.is_interactive) {
+  if (!program_args.script_src.empty()) {
+    // commands are run back to back, so nothing should wait for or clear the console
+    SetClearScreenEnabled(false);
+
+    Cui c(Cui::HintLevel::kNone);
+    AddCommands(&c, g);
+
+    LOG_D("Invoking RunScript()");
+    if (program_args.script_src == "-") {
+      return RunScript(&c, std::cin) ? 0 : 1;
+    }
+
+    auto script_stream = std::ifstream(program_args.script_src);
+    if (!script_stream) {
+      cout << program_args.script_src << ": File not found." << endl;
+      return 1;
+    }
+    return RunScript(&c, script_stream) ? 0 : 1;
+  } else if (!program_args.is_interactive) {
     if (program_args.ni_args.empty()) {
-      Log::w("No interactive mode arguments! Quitting");
+      LOG_W("No interactive mode arguments! Quitting");
       cout << "No arguments provided for non-interactive mode. Exiting." << endl;
 
       return 0;
     }
 
     Cui c(Cui::HintLevel::kNone);
-    c.AddItem("Find", "find", std::bind(&Gui::Find, g, std::placeholders::_1, false));
-    c.AddItem("View", "view", std::bind(&Gui::View, g, std::placeholders::_1));
-    c.AddItem("Sort", "sort", std::bind(&Gui::Sort, g, std::placeholders::_1));
-    c.AddItem("Compare", "compare", std::bind(&Gui::Compare, g, std::placeholders::_1));
-    c.AddItem("json-struct", "json-struct", std::bind(&Gui::JsonStructure, g, std::placeholders::_1));
-    c.AddItem("json-dump", "json-dump", std::bind(&Gui::JsonDump, g, std::placeholders::_1));
-    c.AddItem("Help", "help", std::bind(&Gui::Help, g, false));
-
-    Log::d("Invoking Cui::Parse()");
+    AddCommands(&c, g);
+
+    LOG_D("Invoking Cui::Parse()");
     c.Parse(JoinToString(program_args.ni_args, " "));
   } else {
-    Log::d("Invoking Gui::MainMenu()");
+    LOG_D("Invoking Gui::MainMenu()");
     g.MainMenu();
   }
 
@@ -0,0 +1,68 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for MappedFile class.
+//
+
+#include "mapped_file.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& filename) {
+#if !defined(_WIN32)
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open file");
+  }
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("Cannot read file size");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+
+  // mmap does not accept zero-length mappings
+  if (size_ != 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Cannot map file");
+    }
+    madvise(addr, size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(addr);
+    is_mapped_ = true;
+  }
+  close(fd);
+#else
+  auto ifs = std::ifstream(filename, std::ios::binary);
+  if (!ifs) {
+    throw std::runtime_error("Cannot open file");
+  }
+  buffer_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  size_ = buffer_.size();
+#endif  // !defined(_WIN32)
+
+  if (!is_mapped_) {
+    data_ = buffer_.data();
+  }
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+  if (is_mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif  // !defined(_WIN32)
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for read-only random access of whole files.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_MAPPED_FILE_H_
+#define WARFRAME_PACKAGES_DEPARSER_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only view of a whole file.
+ *
+ * On POSIX systems the file is memory-mapped. On other systems the file is read into memory.
+ */
+class MappedFile {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param filename Name of file to map
+   *
+   * @throw @c std::runtime_error if the file cannot be opened or mapped
+   */
+  explicit MappedFile(const std::string& filename);
+
+  MappedFile(MappedFile&&) = delete;
+  MappedFile(const MappedFile&) = delete;
+  auto operator=(MappedFile&&) noexcept -> MappedFile& = delete;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+  ~MappedFile();
+
+  /**
+   * @return Pointer to the first byte of the file
+   */
+  auto GetData() const -> const char* { return data_; }
+  /**
+   * @return Size of the file in bytes
+   */
+  auto GetSize() const -> std::size_t { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+
+  std::string buffer_ = "";
+  bool is_mapped_ = false;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_MAPPED_FILE_H_
@@ -0,0 +1,189 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for line-based text diffs.
+//
+
+#include "myers_diff.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hash.h"
+#include "profiler.h"
+
+namespace {
+/**
+ * @brief Formats a hunk range for the header of a unified diff hunk.
+ *
+ * @param first_line One-based line number of the first line of the range
+ * @param count Number of lines in the range
+ * @return Formatted range
+ */
+auto FormatRange(unsigned first_line, unsigned count) -> std::string {
+  // empty ranges refer to the line before the range, as in GNU diff
+  if (count == 0) {
+    return std::to_string(first_line - 1) + ",0";
+  }
+  if (count == 1) {
+    return std::to_string(first_line);
+  }
+  return std::to_string(first_line) + "," + std::to_string(count);
+}
+}  // namespace
+
+auto MyersDiff(const std::vector<std::uint64_t>& a, const std::vector<std::uint64_t>& b) -> std::vector<EditOp> {
+  PROFILE_ZONE("MyersDiff");
+  // lines common to the start and end of both sequences are always kept, so only the middle needs to be searched
+  std::size_t prefix = 0;
+  while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+    ++prefix;
+  }
+  std::size_t suffix = 0;
+  while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+         a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix]) {
+    ++suffix;
+  }
+
+  const auto a_begin = a.begin() + static_cast<std::ptrdiff_t>(prefix);
+  const auto b_begin = b.begin() + static_cast<std::ptrdiff_t>(prefix);
+  const auto n = static_cast<std::ptrdiff_t>(a.size() - prefix - suffix);
+  const auto m = static_cast<std::ptrdiff_t>(b.size() - prefix - suffix);
+  const std::ptrdiff_t max = n + m;
+
+  // v[k] holds the furthest x reached on diagonal k; trace[d] holds v[-d..d] before the d-th step
+  auto v = std::vector<std::ptrdiff_t>(static_cast<std::size_t>(2 * max + 3), 0);
+  const std::ptrdiff_t offset = max + 1;
+  auto trace = std::vector<std::vector<std::ptrdiff_t>>();
+  auto v_at = [&](std::ptrdiff_t k) -> std::ptrdiff_t& { return v[static_cast<std::size_t>(offset + k)]; };
+
+  std::ptrdiff_t d = 0;
+  for (; d <= max; ++d) {
+    trace.emplace_back(v.begin() + (offset - d), v.begin() + (offset + d + 1));
+
+    bool is_done = false;
+    for (std::ptrdiff_t k = -d; k <= d; k += 2) {
+      std::ptrdiff_t x;
+      if (k == -d || (k != d && v_at(k - 1) < v_at(k + 1))) {
+        x = v_at(k + 1);
+      } else {
+        x = v_at(k - 1) + 1;
+      }
+      std::ptrdiff_t y = x - k;
+      while (x < n && y < m && a_begin[x] == b_begin[y]) {
+        ++x;
+        ++y;
+      }
+      v_at(k) = x;
+
+      if (x >= n && y >= m) {
+        is_done = true;
+        break;
+      }
+    }
+
+    if (is_done) {
+      break;
+    }
+  }
+
+  // backtrack from the end to recover the edit script in reverse
+  auto edits = std::vector<EditOp>(suffix, EditOp::kKeep);
+  std::ptrdiff_t x = n;
+  std::ptrdiff_t y = m;
+  for (; d > 0; --d) {
+    const std::vector<std::ptrdiff_t>& prev_v = trace[static_cast<std::size_t>(d)];
+    auto at = [&](std::ptrdiff_t k) { return prev_v[static_cast<std::size_t>(k + d)]; };
+
+    const std::ptrdiff_t k = x - y;
+    const std::ptrdiff_t prev_k = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+    const std::ptrdiff_t prev_x = at(prev_k);
+    const std::ptrdiff_t prev_y = prev_x - prev_k;
+
+    while (x > prev_x && y > prev_y) {
+      edits.push_back(EditOp::kKeep);
+      --x;
+      --y;
+    }
+    edits.push_back(x == prev_x ? EditOp::kInsert : EditOp::kDelete);
+    x = prev_x;
+    y = prev_y;
+  }
+  edits.insert(edits.end(), static_cast<std::size_t>(x) + prefix, EditOp::kKeep);
+
+  std::reverse(edits.begin(), edits.end());
+  return edits;
+}
+
+auto HashLines(const std::vector<std::string>& lines) -> std::vector<std::uint64_t> {
+  auto hashes = std::vector<std::uint64_t>();
+  hashes.reserve(lines.size());
+  for (auto&& l : lines) {
+    hashes.push_back(XxHash64(l.data(), l.size()));
+  }
+  return hashes;
+}
+
+auto FormatUnifiedHunks(const std::vector<std::string>& a, const std::vector<std::string>& b,
+                        const std::vector<EditOp>& edits, unsigned a_first_line, unsigned b_first_line,
+                        unsigned context, const std::string& section) -> std::string {
+  // position of each edit in both sequences
+  auto a_pos = std::vector<std::size_t>(edits.size() + 1, 0);
+  auto b_pos = std::vector<std::size_t>(edits.size() + 1, 0);
+  auto changes = std::vector<std::size_t>();
+  for (std::size_t i = 0; i < edits.size(); ++i) {
+    a_pos[i + 1] = a_pos[i] + static_cast<std::size_t>(edits[i] != EditOp::kInsert);
+    b_pos[i + 1] = b_pos[i] + static_cast<std::size_t>(edits[i] != EditOp::kDelete);
+    if (edits[i] != EditOp::kKeep) {
+      changes.push_back(i);
+    }
+  }
+
+  std::string out;
+  for (std::size_t c = 0; c < changes.size();) {
+    // changes separated by at most twice the context are merged into the same hunk
+    std::size_t last = c;
+    while (last + 1 < changes.size() && changes[last + 1] - changes[last] - 1 <= 2 * std::size_t{context}) {
+      ++last;
+    }
+
+    const std::size_t begin = changes[c] - std::min<std::size_t>(changes[c], context);
+    const std::size_t end = std::min(edits.size(), changes[last] + 1 + context);
+
+    out.append("@@ -");
+    out.append(FormatRange(a_first_line + static_cast<unsigned>(a_pos[begin]),
+                           static_cast<unsigned>(a_pos[end] - a_pos[begin])));
+    out.append(" +");
+    out.append(FormatRange(b_first_line + static_cast<unsigned>(b_pos[begin]),
+                           static_cast<unsigned>(b_pos[end] - b_pos[begin])));
+    out.append(" @@");
+    if (!section.empty()) {
+      out.append(" ").append(section);
+    }
+    out.push_back('\n');
+
+    for (std::size_t i = begin; i < end; ++i) {
+      switch (edits[i]) {
+        case EditOp::kKeep:
+          out.append(" ").append(a[a_pos[i]]);
+          break;
+        case EditOp::kDelete:
+          out.append("-").append(a[a_pos[i]]);
+          break;
+        case EditOp::kInsert:
+          out.append("+").append(b[b_pos[i]]);
+          break;
+        default:
+          // all cases covered
+          break;
+      }
+      out.push_back('\n');
+    }
+
+    c = last + 1;
+  }
+
+  return out;
+}
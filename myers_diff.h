@@ -0,0 +1,65 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for line-based text diffs.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_MYERS_DIFF_H_
+#define WARFRAME_PACKAGES_DEPARSER_MYERS_DIFF_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A single step of an edit script.
+ */
+enum struct EditOp : unsigned char {
+  /**
+   * @brief Line exists in both sequences.
+   */
+  kKeep,
+  /**
+   * @brief Line only exists in the old sequence.
+   */
+  kDelete,
+  /**
+   * @brief Line only exists in the new sequence.
+   */
+  kInsert
+};
+
+/**
+ * @brief Computes a shortest edit script between two sequences of line hashes, using Myers' O(ND) algorithm.
+ *
+ * @param a Hashes of the lines of the old sequence
+ * @param b Hashes of the lines of the new sequence
+ * @return Edit script transforming @p a into @p b
+ */
+auto MyersDiff(const std::vector<std::uint64_t>& a, const std::vector<std::uint64_t>& b) -> std::vector<EditOp>;
+
+/**
+ * @brief Computes the hash of every line, for use with @c MyersDiff.
+ *
+ * @param lines Lines to hash
+ * @return Hash of every line
+ */
+auto HashLines(const std::vector<std::string>& lines) -> std::vector<std::uint64_t>;
+
+/**
+ * @brief Formats an edit script as unified diff hunks.
+ *
+ * @param a Lines of the old sequence
+ * @param b Lines of the new sequence
+ * @param edits Edit script transforming @p a into @p b
+ * @param a_first_line One-based line number of the first line of @p a in its file
+ * @param b_first_line One-based line number of the first line of @p b in its file
+ * @param context Number of unchanged lines to show around each change
+ * @param section Section heading to show after each hunk range
+ * @return Unified diff hunks
+ */
+auto FormatUnifiedHunks(const std::vector<std::string>& a, const std::vector<std::string>& b,
+                        const std::vector<EditOp>& edits, unsigned a_first_line, unsigned b_first_line,
+                        unsigned context, const std::string& section) -> std::string;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_MYERS_DIFF_H_
@@ -0,0 +1,385 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for field-level comparison of package bodies.
+//
+
+#include "package_diff.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "profiler.h"
+
+namespace {
+/**
+ * @brief Escapes a key for use as a JSON Pointer reference token.
+ *
+ * @param key Key to escape
+ * @return Escaped key
+ */
+auto EscapePointer(const std::string& key) -> std::string {
+  std::string out;
+  out.reserve(key.size());
+  for (char c : key) {
+    if (c == '~') {
+      out.append("~0");
+    } else if (c == '/') {
+      out.append("~1");
+    } else {
+      out.push_back(c);
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Appends a string as a quoted JSON string.
+ *
+ * @param str String to append
+ * @param out String to append to
+ */
+void AppendJsonString(const std::string& str, std::string* const out) {
+  static const char kHexDigits[] = "0123456789abcdef";
+
+  out->push_back('"');
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out->append("\\u00");
+          out->push_back(kHexDigits[(c >> 4) & 0xF]);
+          out->push_back(kHexDigits[c & 0xF]);
+        } else {
+          out->push_back(c);
+        }
+        break;
+    }
+  }
+  out->push_back('"');
+}
+
+/**
+ * @brief Checks whether a field is nested within another field.
+ *
+ * @param fields All fields of the package
+ * @param field Index of the field to check
+ * @param ancestor Index of the possible ancestor
+ * @return True if @p field is a descendant of @p ancestor
+ */
+bool IsDescendant(const std::vector<PackageField>& fields, std::size_t field, std::size_t ancestor) {
+  for (std::size_t p = fields[field].parent; p != PackageField::kNoParent; p = fields[p].parent) {
+    if (p == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Appends a field and all its children as a JSON value.
+ *
+ * @param fields All fields of the package
+ * @param index Index of the field to append
+ * @param out String to append to
+ */
+void AppendJsonValue(const std::vector<PackageField>& fields, std::size_t index, std::string* const out) {
+  const PackageField& field = fields[index];
+  if (field.kind == PackageField::Kind::kValue) {
+    AppendJsonString(field.value, out);
+    return;
+  }
+
+  const bool is_array = field.kind == PackageField::Kind::kArray;
+  out->push_back(is_array ? '[' : '{');
+
+  // children are always stored after their parent, and subtrees are contiguous
+  bool is_first = true;
+  for (std::size_t i = index + 1; i < fields.size() && IsDescendant(fields, i, index); ++i) {
+    if (fields[i].parent != index) {
+      continue;
+    }
+
+    if (!is_first) {
+      out->push_back(',');
+    }
+    is_first = false;
+
+    if (!is_array) {
+      AppendJsonString(fields[i].key, out);
+      out->push_back(':');
+    }
+    AppendJsonValue(fields, i, out);
+  }
+
+  out->push_back(is_array ? ']' : '}');
+}
+
+/**
+ * @brief Describes the value of a field for human-readable output.
+ *
+ * @param field Field to describe
+ * @return Description of the value
+ */
+auto DescribeValue(const PackageField& field) -> std::string {
+  switch (field.kind) {
+    case PackageField::Kind::kValue:
+      return field.value.empty() ? "\"\"" : field.value;
+    case PackageField::Kind::kArray:
+      return field.has_children ? "[...]" : "[]";
+    case PackageField::Kind::kObject:
+      return field.has_children ? "{...}" : "{}";
+    default:
+      // all cases covered
+      return "";
+  }
+}
+}  // namespace
+
+PackageField::~PackageField() = default;
+
+auto ReadPackageBody(const MappedFile& file, std::uint64_t offset, bool inc_header, bool keep_cr)
+    -> std::vector<std::string> {
+  const char* const data_end = file.GetData() + file.GetSize();
+  const char* it = file.GetData() + std::min<std::uint64_t>(offset, file.GetSize());
+
+  auto lines = std::vector<std::string>();
+  for (bool is_header = true; it != data_end; is_header = false) {
+    const char* line_end = std::find(it, data_end, '\n');
+    auto line = std::string(it, line_end);
+    it = line_end == data_end ? data_end : line_end + 1;
+
+    if (is_header) {
+      if (!inc_header) {
+        continue;
+      }
+    } else if (line.find("FullPackageName=") != std::string::npos) {
+      break;
+    }
+
+    // remove trailing CR character in *nix systems
+    if (!keep_cr && !line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    lines.emplace_back(std::move(line));
+  }
+
+  return lines;
+}
+
+auto FlattenPackageBody(const std::vector<std::string>& lines) -> std::vector<PackageField> {
+  struct Frame {
+    std::size_t field;
+    bool is_array;
+    unsigned next_index;
+  };
+
+  auto fields = std::vector<PackageField>();
+  auto stack = std::vector<Frame>();
+  auto id_count = std::unordered_map<std::string, unsigned>();
+
+  // adds a field beneath the innermost open array or object; fields without a key are treated as array elements
+  auto add_field = [&](PackageField::Kind kind, const std::string& key, bool has_key, std::string value) {
+    PackageField field{kind, key, "", "", "", std::move(value), PackageField::kNoParent, false};
+    std::string pointer_token = EscapePointer(key);
+
+    if (!stack.empty()) {
+      Frame& frame = stack.back();
+      const PackageField& parent = fields[frame.field];
+      field.parent = frame.field;
+      fields[frame.field].has_children = true;
+
+      if (has_key) {
+        field.path = parent.path + "::" + key;
+      } else {
+        pointer_token = std::to_string(frame.next_index++);
+        field.path = parent.path + "[" + pointer_token + "]";
+      }
+      field.pointer = parent.pointer + "/" + pointer_token;
+    } else {
+      field.path = has_key ? key : "[]";
+      field.pointer = "/" + pointer_token;
+    }
+
+    // keys which appear more than once in an object are aligned by their order of appearance
+    const unsigned count = id_count[field.path]++;
+    field.id = count == 0 ? field.path : field.path + "#" + std::to_string(count);
+
+    fields.emplace_back(std::move(field));
+    return fields.size() - 1;
+  };
+
+  // tokens are recognized in the same order as Packages::HeaderToJson
+  for (auto line : lines) {
+    line.erase(0, line.find_first_not_of(" \t"));
+    if (line.empty() || line.find("UNPARSEABLEcONTENTS") != std::string::npos) {
+      continue;
+    }
+
+    const std::string::size_type entry_token = line.find('=');
+    const std::string::size_type barray_token = line.find("=[");
+    const std::string::size_type bobject_token = line.find("={");
+
+    if (line.find("[]") != std::string::npos) {
+      add_field(PackageField::Kind::kArray, line.substr(0, barray_token), true, "");
+    } else if (line.find("{}") != std::string::npos) {
+      add_field(PackageField::Kind::kObject, line.substr(0, bobject_token), true, "");
+    } else if (line == "]" || line == "],") {
+      if (!stack.empty() && stack.back().is_array) {
+        stack.pop_back();
+      }
+    } else if (barray_token != std::string::npos) {
+      stack.push_back({add_field(PackageField::Kind::kArray, line.substr(0, barray_token), true, ""), true, 0});
+    } else if (line == "}" || line == "},") {
+      if (!stack.empty() && !stack.back().is_array) {
+        stack.pop_back();
+      }
+    } else if (line == "{") {
+      stack.push_back({add_field(PackageField::Kind::kObject, "", false, ""), false, 0});
+    } else if (line == "[") {
+      stack.push_back({add_field(PackageField::Kind::kArray, "", false, ""), true, 0});
+    } else if (bobject_token != std::string::npos) {
+      stack.push_back({add_field(PackageField::Kind::kObject, line.substr(0, bobject_token), true, ""), false, 0});
+    } else if (entry_token != std::string::npos) {
+      std::string value = line.substr(entry_token + 1);
+      if (value == "\"\"") {
+        value.clear();
+      }
+      add_field(PackageField::Kind::kValue, line.substr(0, entry_token), true, std::move(value));
+    } else {
+      if (line.back() == ',') {
+        line.pop_back();
+      }
+      add_field(PackageField::Kind::kValue, "", false, std::move(line));
+    }
+  }
+
+  return fields;
+}
+
+auto DiffPackageFields(const std::vector<PackageField>& from, const std::vector<PackageField>& to)
+    -> std::vector<FieldChange> {
+  PROFILE_ZONE("DiffPackageFields");
+  constexpr std::size_t kNone = PackageField::kNoParent;
+
+  auto from_ids = std::unordered_map<std::string, std::size_t>();
+  for (std::size_t i = 0; i < from.size(); ++i) {
+    from_ids.emplace(from[i].id, i);
+  }
+  auto to_ids = std::unordered_map<std::string, std::size_t>();
+  for (std::size_t i = 0; i < to.size(); ++i) {
+    to_ids.emplace(to[i].id, i);
+  }
+
+  auto changes = std::vector<FieldChange>();
+
+  // a field is covered if it, or one of its ancestors, is added, removed or replaced as a whole
+  auto from_covered = std::vector<bool>(from.size(), false);
+  for (std::size_t i = 0; i < from.size(); ++i) {
+    if (from[i].parent != kNone && from_covered[from[i].parent]) {
+      from_covered[i] = true;
+      continue;
+    }
+
+    auto it = to_ids.find(from[i].id);
+    if (it == to_ids.end()) {
+      changes.push_back({FieldChange::Op::kRemove, i, kNone});
+      from_covered[i] = true;
+    } else if (to[it->second].kind != from[i].kind) {
+      from_covered[i] = true;
+    }
+  }
+
+  auto to_covered = std::vector<bool>(to.size(), false);
+  for (std::size_t i = 0; i < to.size(); ++i) {
+    if (to[i].parent != kNone && to_covered[to[i].parent]) {
+      to_covered[i] = true;
+      continue;
+    }
+
+    auto it = from_ids.find(to[i].id);
+    if (it == from_ids.end()) {
+      changes.push_back({FieldChange::Op::kAdd, kNone, i});
+      to_covered[i] = true;
+    } else if (from[it->second].kind != to[i].kind) {
+      changes.push_back({FieldChange::Op::kReplace, it->second, i});
+      to_covered[i] = true;
+    } else if (to[i].kind == PackageField::Kind::kValue && from[it->second].value != to[i].value) {
+      changes.push_back({FieldChange::Op::kReplace, it->second, i});
+    }
+  }
+
+  return changes;
+}
+
+auto FormatFieldChanges(const std::vector<FieldChange>& changes, const std::vector<PackageField>& from,
+                        const std::vector<PackageField>& to) -> std::string {
+  std::string out;
+  for (auto&& c : changes) {
+    switch (c.op) {
+      case FieldChange::Op::kAdd:
+        out.append("+ ").append(to[c.to].path).append(" = ").append(DescribeValue(to[c.to]));
+        break;
+      case FieldChange::Op::kRemove:
+        out.append("- ").append(from[c.from].path).append(" = ").append(DescribeValue(from[c.from]));
+        break;
+      case FieldChange::Op::kReplace:
+        out.append("~ ").append(to[c.to].path).append(": ").append(DescribeValue(from[c.from]));
+        out.append(" -> ").append(DescribeValue(to[c.to]));
+        break;
+      default:
+        // all cases covered
+        break;
+    }
+    out.push_back('\n');
+  }
+  return out;
+}
+
+auto FormatJsonPatch(const std::vector<FieldChange>& changes, const std::vector<PackageField>& from,
+                     const std::vector<PackageField>& to, const std::string& package_key) -> std::string {
+  const std::string prefix = package_key.empty() ? std::string() : "/" + EscapePointer(package_key);
+
+  std::string out;
+  auto append_op = [&](const char* op, const std::string& pointer, std::size_t value_index) {
+    if (!out.empty()) {
+      out.append(",\n");
+    }
+    out.append(R"(  {"op":")").append(op).append(R"(","path":)");
+    AppendJsonString(prefix + pointer, &out);
+    if (value_index != PackageField::kNoParent) {
+      out.append(R"(,"value":)");
+      AppendJsonValue(to, value_index, &out);
+    }
+    out.push_back('}');
+  };
+
+  // removals are applied from the back, so that earlier array indices remain valid
+  for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+    if (it->op == FieldChange::Op::kRemove) {
+      append_op("remove", from[it->from].pointer, PackageField::kNoParent);
+    }
+  }
+  for (auto&& c : changes) {
+    if (c.op == FieldChange::Op::kAdd) {
+      append_op("add", to[c.to].pointer, c.to);
+    } else if (c.op == FieldChange::Op::kReplace) {
+      append_op("replace", to[c.to].pointer, c.to);
+    }
+  }
+
+  return out;
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for field-level comparison of package bodies.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIFF_H_
+#define WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIFF_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * @brief A single field of a package body, as walked by @c Packages::HeaderToJson.
+ */
+struct PackageField {
+  enum struct Kind {
+    /**
+     * @brief Key-value pair, or bare array element.
+     */
+    kValue,
+    /**
+     * @brief Array, which may be empty.
+     */
+    kArray,
+    /**
+     * @brief Object, which may be empty.
+     */
+    kObject
+  };
+
+  Kind kind;
+  /**
+   * @brief Key of the field. Empty for array elements.
+   */
+  std::string key;
+  /**
+   * @brief "::"-delimited path of the field, with array elements written as "[index]".
+   */
+  std::string path;
+  /**
+   * @brief JSON Pointer (RFC 6901) of the field.
+   */
+  std::string pointer;
+  /**
+   * @brief Path of the field, disambiguated for keys which appear more than once in the same object.
+   */
+  std::string id;
+  /**
+   * @brief Value of the field. Empty for arrays and objects.
+   */
+  std::string value;
+  /**
+   * @brief Index of the parent field, or @c kNoParent for top-level fields.
+   */
+  std::size_t parent;
+  /**
+   * @brief Whether the field is an array or object with at least one child.
+   */
+  bool has_children;
+
+  static constexpr std::size_t kNoParent = static_cast<std::size_t>(-1);
+
+  PackageField() = default;
+  PackageField(const PackageField&) = default;
+  PackageField(PackageField&&) = default;
+  auto operator=(const PackageField&) -> PackageField& = default;
+  auto operator=(PackageField&&) -> PackageField& = default;
+  ~PackageField();
+};
+
+/**
+ * @brief A single difference between two versions of a package.
+ */
+struct FieldChange {
+  enum struct Op {
+    kAdd,
+    kRemove,
+    kReplace
+  };
+
+  Op op;
+  /**
+   * @brief Index of the field in the old version, or @c PackageField::kNoParent if the field is added.
+   */
+  std::size_t from;
+  /**
+   * @brief Index of the field in the new version, or @c PackageField::kNoParent if the field is removed.
+   */
+  std::size_t to;
+};
+
+/**
+ * @brief Reads the body of a package.
+ *
+ * @param file Mapped Packages file
+ * @param offset Byte offset of the header line of the package
+ * @param inc_header Whether to include the header line
+ * @param keep_cr Whether to keep trailing CR characters, so that the lines are reproduced exactly
+ * @return Lines of the body
+ */
+auto ReadPackageBody(const MappedFile& file, std::uint64_t offset, bool inc_header = false, bool keep_cr = false)
+    -> std::vector<std::string>;
+
+/**
+ * @brief Flattens a package body into its fields, in document order.
+ *
+ * @param lines Lines of the package body
+ * @return All fields of the package body
+ */
+auto FlattenPackageBody(const std::vector<std::string>& lines) -> std::vector<PackageField>;
+
+/**
+ * @brief Computes the minimal set of changes between two versions of a package.
+ *
+ * Fields are aligned by their path, hence array elements are aligned by their index. Changes beneath an added or
+ * removed field are not reported separately.
+ *
+ * @param from Fields of the old version
+ * @param to Fields of the new version
+ * @return Changes in document order, removals first
+ */
+auto DiffPackageFields(const std::vector<PackageField>& from, const std::vector<PackageField>& to)
+    -> std::vector<FieldChange>;
+
+/**
+ * @brief Formats a list of changes as human-readable text, one change per line.
+ *
+ * @param changes Changes to format
+ * @param from Fields of the old version
+ * @param to Fields of the new version
+ * @return Formatted changes
+ */
+auto FormatFieldChanges(const std::vector<FieldChange>& changes, const std::vector<PackageField>& from,
+                        const std::vector<PackageField>& to) -> std::string;
+
+/**
+ * @brief Formats a list of changes as a JSON Patch (RFC 6902) document.
+ *
+ * @param changes Changes to format
+ * @param from Fields of the old version
+ * @param to Fields of the new version
+ * @param package_key If non-empty, key of the package in the patched document, which is prepended to all paths
+ * @return Patch operations separated by commas, without enclosing brackets
+ */
+auto FormatJsonPatch(const std::vector<FieldChange>& changes, const std::vector<PackageField>& from,
+                     const std::vector<PackageField>& to, const std::string& package_key) -> std::string;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIFF_H_
@@ -0,0 +1,262 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for package digest utilities.
+//
+
+#include "package_digest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hash.h"
+#include "log.h"
+#include "mapped_file.h"
+#include "profiler.h"
+#include "text_search.h"
+#include "util.h"
+
+namespace {
+const char kDigestMagic[] = "WFPDDIG2";
+constexpr std::size_t kDigestMagicLength = sizeof(kDigestMagic) - 1;
+
+/**
+ * @brief Reads the digests from a sidecar file.
+ *
+ * @param filename Name of the sidecar file
+ * @param file_size Size of the Packages file, for checking whether the sidecar file is stale
+ * @param file_mtime Modification time of the Packages file, for checking whether the sidecar file is stale
+ * @param digests Vector to read the digests into
+ * @return True if successful
+ */
+bool ReadDigestFile(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime,
+                    std::vector<PackageDigest>* const digests) {
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(filename);
+  } catch (std::runtime_error& ex_runtime) {
+    return false;
+  }
+
+  const char* it = file->GetData();
+  const char* const end = it + file->GetSize();
+  if (file->GetSize() < kDigestMagicLength || std::memcmp(it, kDigestMagic, kDigestMagicLength) != 0) {
+    return false;
+  }
+  it += kDigestMagicLength;
+
+  std::uint64_t saved_size;
+  std::uint64_t saved_mtime;
+  std::uint64_t count;
+  if (!ReadVarint(&it, end, &saved_size) || !ReadVarint(&it, end, &saved_mtime) || !ReadVarint(&it, end, &count)) {
+    return false;
+  }
+  if (saved_size != file_size || static_cast<std::int64_t>(saved_mtime) != file_mtime) {
+    LOG_I("Digest file \"" + filename + "\" is stale");
+    return false;
+  }
+
+  digests->clear();
+  digests->reserve(std::min<std::uint64_t>(count, file->GetSize()));
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::uint64_t length;
+    PackageDigest d{};
+    if (!ReadVarint(&it, end, &length) || static_cast<std::uint64_t>(end - it) < length) {
+      return false;
+    }
+    d.name.assign(it, length);
+    it += length;
+
+    std::uint64_t line;
+    if (!ReadVarint(&it, end, &d.hash) || !ReadVarint(&it, end, &d.offset) || !ReadVarint(&it, end, &line)) {
+      return false;
+    }
+    d.line = static_cast<unsigned>(line);
+    digests->emplace_back(std::move(d));
+  }
+
+  return true;
+}
+
+/**
+ * @brief Writes the digests to a sidecar file.
+ *
+ * @param filename Name of the sidecar file
+ * @param file_size Size of the Packages file
+ * @param file_mtime Modification time of the Packages file
+ * @param digests Digests to write
+ * @return True if successful
+ */
+bool WriteDigestFile(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime,
+                     const std::vector<PackageDigest>& digests) {
+  std::string buffer(kDigestMagic, kDigestMagicLength);
+  WriteVarint(&buffer, file_size);
+  WriteVarint(&buffer, static_cast<std::uint64_t>(file_mtime));
+  WriteVarint(&buffer, digests.size());
+  for (auto&& d : digests) {
+    WriteVarint(&buffer, d.name.size());
+    buffer.append(d.name);
+    WriteVarint(&buffer, d.hash);
+    WriteVarint(&buffer, d.offset);
+    WriteVarint(&buffer, d.line);
+  }
+
+  auto ofs = std::ofstream(filename, std::ios::binary);
+  if (!ofs) {
+    return false;
+  }
+  ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  return static_cast<bool>(ofs);
+}
+}  // namespace
+
+auto HashPackageBody(const char* begin, const char* const end, std::string* const buffer) -> std::uint64_t {
+  buffer->clear();
+
+  while (begin < end) {
+    const char* line_end = std::find(begin, end, '\n');
+    const char* next = line_end == end ? end : line_end + 1;
+
+    // strip indentation and the trailing CR character
+    while (begin != line_end && (*begin == ' ' || *begin == '\t')) {
+      ++begin;
+    }
+    if (line_end != begin && line_end[-1] == '\r') {
+      --line_end;
+    }
+
+    if (begin != line_end) {
+      buffer->append(begin, line_end);
+      buffer->push_back('\n');
+    }
+
+    begin = next;
+  }
+
+  return XxHash64(buffer->data(), buffer->size());
+}
+
+auto CombineBodyHash(std::uint64_t a, std::uint64_t b) -> std::uint64_t {
+  return (a ^ (b + 0x9E3779B97F4A7C15ULL + (a << 6) + (a >> 2))) * 0x9E3779B97F4A7C15ULL;
+}
+
+auto ScanPackageDigests(const MappedFile& file) -> std::vector<PackageDigest> {
+  PROFILE_ZONE("ScanPackageDigests");
+  LOG_D("ScanPackageDigests");
+  Profiler::AddBytes(file.GetSize());
+
+  const char* const data = file.GetData();
+  const char* const data_end = data + file.GetSize();
+
+  // split the file into one chunk per worker, with all chunks beginning at the start of a line
+  const std::size_t chunk_count = GetWorkerCount();
+  auto bounds = std::vector<const char*>(chunk_count + 1, data_end);
+  bounds[0] = data;
+  for (std::size_t c = 1; c < chunk_count; ++c) {
+    const char* p = std::max(bounds[c - 1], data + file.GetSize() / chunk_count * c);
+    p = std::find(p, data_end, '\n');
+    bounds[c] = p == data_end ? data_end : p + 1;
+  }
+
+  // find all header lines of each chunk, with line numbers relative to the start of the chunk
+  auto chunk_digests = std::vector<std::vector<PackageDigest>>(chunk_count);
+  auto chunk_line_counts = std::vector<unsigned>(chunk_count);
+  const LiteralSearcher searcher("FullPackageName=");
+  ParallelChunks(chunk_count, [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t c = begin; c < end; ++c) {
+      const char* const chunk_end = bounds[c + 1];
+      const char* line = bounds[c];
+      unsigned line_count = 0;
+      for (const char* p = line; (p = searcher.Find(p, chunk_end)) != chunk_end;) {
+        const char* line_begin = p;
+        while (line_begin != line && line_begin[-1] != '\n') {
+          --line_begin;
+        }
+        const char* line_end = std::find(p, chunk_end, '\n');
+        const char* name_end = line_end != p && line_end[-1] == '\r' ? line_end - 1 : line_end;
+
+        line_count += static_cast<unsigned>(std::count(line, line_begin, '\n'));
+        chunk_digests[c].push_back({std::string(p + 16, std::max(p + 16, name_end)), 0,
+                                    static_cast<std::uint64_t>(line_begin - data), line_count});
+
+        p = line_end == chunk_end ? chunk_end : line_end + 1;
+        line_count += static_cast<unsigned>(p != line_end);
+        line = p;
+      }
+      chunk_line_counts[c] = line_count + static_cast<unsigned>(std::count(line, chunk_end, '\n'));
+    }
+  });
+
+  auto digests = std::vector<PackageDigest>();
+  unsigned first_line = 0;
+  for (std::size_t c = 0; c < chunk_count; ++c) {
+    for (auto&& d : chunk_digests[c]) {
+      d.line += first_line;
+      digests.emplace_back(std::move(d));
+    }
+    first_line += chunk_line_counts[c];
+  }
+
+  // hash the body of each header, which spans from the line after the header to the next header
+  ParallelChunks(digests.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+    std::string buffer;
+    for (std::size_t i = begin; i < end; ++i) {
+      const char* body_end = i + 1 < digests.size() ? data + digests[i + 1].offset : data_end;
+      const char* body_begin = std::find(data + digests[i].offset, body_end, '\n');
+      if (body_begin != body_end) {
+        ++body_begin;
+      }
+
+      digests[i].hash = HashPackageBody(body_begin, body_end, &buffer);
+    }
+  });
+
+  // sort by name, and combine the hashes of headers which are defined more than once
+  std::stable_sort(digests.begin(), digests.end(),
+                   [](const PackageDigest& a, const PackageDigest& b) { return a.name < b.name; });
+  auto out = digests.begin();
+  for (auto it = digests.begin(); it != digests.end(); ++it) {
+    if (out != digests.begin() && (out - 1)->name == it->name) {
+      (out - 1)->hash = CombineBodyHash((out - 1)->hash, it->hash);
+    } else {
+      if (out != it) {
+        *out = std::move(*it);
+      }
+      ++out;
+    }
+  }
+  digests.erase(out, digests.end());
+
+  return digests;
+}
+
+auto LoadPackageDigests(const std::string& filename) -> std::vector<PackageDigest> {
+  PROFILE_ZONE("LoadPackageDigests");
+  LOG_D("LoadPackageDigests(" + filename + ")");
+
+  const std::string digest_filename = filename + ".digest";
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0;
+  const bool has_stamp = GetFileStamp(filename, &size, &mtime);
+
+  auto digests = std::vector<PackageDigest>();
+  if (has_stamp && ReadDigestFile(digest_filename, size, mtime, &digests)) {
+    LOG_I("Loaded package digests from \"" + digest_filename + "\"");
+    return digests;
+  }
+
+  const MappedFile file(filename);
+  digests = ScanPackageDigests(file);
+
+  if (!has_stamp || !WriteDigestFile(digest_filename, size, mtime, digests)) {
+    LOG_W("Unable to save package digests to \"" + digest_filename + "\"");
+  }
+
+  return digests;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for identifying the contents of packages.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIGEST_H_
+#define WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIGEST_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * @brief Name and content hash of a package.
+ */
+struct PackageDigest {
+  /**
+   * @brief Name of the header.
+   */
+  std::string name;
+  /**
+   * @brief Hash of the normalized body. See @c HashPackageBody.
+   */
+  std::uint64_t hash;
+  /**
+   * @brief Byte offset of the first header line of the package.
+   */
+  std::uint64_t offset;
+  /**
+   * @brief Zero-based line number of the first header line of the package.
+   */
+  unsigned line;
+};
+
+/**
+ * @brief Computes the hash of a normalized package body.
+ *
+ * Indentation, line endings and empty lines are ignored, so that the raw and diff-optimized formats of the same
+ * package have the same hash.
+ *
+ * @param begin Start of the body, excluding the header line
+ * @param end End of the body
+ * @param buffer Scratch buffer for the normalized body
+ * @return Hash of the normalized body
+ */
+auto HashPackageBody(const char* begin, const char* end, std::string* buffer) -> std::uint64_t;
+
+/**
+ * @brief Combines the hashes of two bodies of a package which is defined more than once.
+ *
+ * @param a Hash of the earlier body
+ * @param b Hash of the later body
+ * @return Combined hash
+ */
+auto CombineBodyHash(std::uint64_t a, std::uint64_t b) -> std::uint64_t;
+
+/**
+ * @brief Extracts the digests of all packages in a file, without constructing a @c Packages.
+ *
+ * @param file Mapped input file
+ * @return Digests of all packages, sorted by name
+ */
+auto ScanPackageDigests(const MappedFile& file) -> std::vector<PackageDigest>;
+
+/**
+ * @brief Loads the digests of all packages in a file from its sidecar file, or scans the file and saves the sidecar
+ * file if it is missing or stale.
+ *
+ * @param filename Name of the Packages file
+ * @return Digests of all packages, sorted by name
+ *
+ * @throw @c std::runtime_error if the file cannot be read
+ */
+auto LoadPackageDigests(const std::string& filename) -> std::vector<PackageDigest>;
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_PACKAGE_DIGEST_H_
@@ -0,0 +1,288 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for PackageStore class.
+//
+
+#include "package_store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hash.h"
+#include "log.h"
+#include "mapped_file.h"
+#include "package_digest.h"
+#include "profiler.h"
+#include "text_search.h"
+#include "util.h"
+
+namespace {
+const char kManifestMagic[] = "WFPDMAN1";
+constexpr std::size_t kManifestMagicLength = sizeof(kManifestMagic) - 1;
+
+/**
+ * @brief Checks whether a version name can be used as part of a filename.
+ *
+ * @param version Name of the version
+ * @return True if the name only consists of letters, digits, '.', '-' and '_'
+ */
+bool IsValidVersionName(const std::string& version) {
+  if (version.empty() || version.front() == '.') {
+    return false;
+  }
+  return std::all_of(version.begin(), version.end(), [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+  });
+}
+}  // namespace
+
+PackageStore::PackageStore(std::string directory) : directory_(std::move(directory)) {
+  if (!MakeDirectory(directory_)) {
+    throw std::runtime_error("Cannot create store directory");
+  }
+
+  LoadVersions();
+  LoadBodies();
+}
+
+auto PackageStore::AddVersion(const std::string& version, const MappedFile& file) -> std::size_t {
+  PROFILE_ZONE("PackageStore::AddVersion");
+  LOG_D("PackageStore::AddVersion(" + version + ")");
+
+  if (!IsValidVersionName(version)) {
+    throw std::runtime_error("Invalid version name");
+  }
+  if (HasVersion(version)) {
+    throw std::runtime_error("Version already exists");
+  }
+
+  const char* const data = file.GetData();
+  const char* const data_end = data + file.GetSize();
+  const auto digests = ScanPackageDigests(file);
+
+  // locate and hash the raw body of each header, which spans from the line after the header to the next header
+  auto body_ranges = std::vector<std::pair<const char*, const char*>>(digests.size());
+  auto body_hashes = std::vector<std::uint64_t>(digests.size());
+  const LiteralSearcher searcher("FullPackageName=");
+  ParallelChunks(digests.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const char* body_begin = std::find(data + digests[i].offset, data_end, '\n');
+      if (body_begin != data_end) {
+        ++body_begin;
+      }
+      const char* body_end = searcher.Find(body_begin, data_end);
+      while (body_end != body_begin && body_end[-1] != '\n') {
+        --body_end;
+      }
+
+      body_ranges[i] = {body_begin, body_end};
+      body_hashes[i] = XxHash64(body_begin, static_cast<std::size_t>(body_end - body_begin));
+    }
+  });
+
+  // append all new bodies after the valid part of the body file. The file is truncated first, so that no bytes of
+  // records partially written by an interrupted ingest remain after the new records
+  const std::string body_filename = GetPath("bodies.dat");
+  {
+    auto create = std::ofstream(body_filename, std::ios::binary | std::ios::app);
+  }
+  if (!TruncateFile(body_filename, body_file_size_)) {
+    throw std::runtime_error("Cannot truncate body file");
+  }
+  auto fs = std::fstream(body_filename, std::ios::binary | std::ios::in | std::ios::out);
+  if (!fs) {
+    throw std::runtime_error("Cannot open body file");
+  }
+  fs.seekp(static_cast<std::streamoff>(body_file_size_));
+
+  std::size_t new_count = 0;
+  std::string record;
+  for (std::size_t i = 0; i < digests.size(); ++i) {
+    if (bodies_.find(body_hashes[i]) != bodies_.end()) {
+      continue;
+    }
+
+    const auto length = static_cast<std::uint64_t>(body_ranges[i].second - body_ranges[i].first);
+    record.clear();
+    WriteVarint(&record, body_hashes[i]);
+    WriteVarint(&record, length);
+    fs.write(record.data(), static_cast<std::streamsize>(record.size()));
+    fs.write(body_ranges[i].first, static_cast<std::streamsize>(length));
+
+    bodies_.emplace(body_hashes[i], BodyLocation{body_file_size_ + record.size(), length});
+    body_file_size_ += record.size() + length;
+    body_size_ += length;
+    ++new_count;
+  }
+  fs.flush();
+  if (!fs) {
+    throw std::runtime_error("Cannot write body file");
+  }
+
+  // the manifest is only listed in the versions file after it is completely written
+  std::string manifest(kManifestMagic, kManifestMagicLength);
+  WriteVarint(&manifest, digests.size());
+  for (std::size_t i = 0; i < digests.size(); ++i) {
+    WriteVarint(&manifest, digests[i].name.size());
+    manifest.append(digests[i].name);
+    WriteVarint(&manifest, body_hashes[i]);
+    WriteVarint(&manifest, digests[i].hash);
+  }
+
+  auto manifest_ofs = std::ofstream(GetPath(version + ".manifest"), std::ios::binary);
+  manifest_ofs.write(manifest.data(), static_cast<std::streamsize>(manifest.size()));
+  manifest_ofs.close();
+  if (!manifest_ofs) {
+    throw std::runtime_error("Cannot write manifest");
+  }
+
+  auto versions_ofs = std::ofstream(GetPath("versions.lst"), std::ios::app);
+  versions_ofs << version << '\n';
+  versions_ofs.close();
+  if (!versions_ofs) {
+    throw std::runtime_error("Cannot write versions file");
+  }
+  versions_.push_back(version);
+
+  return new_count;
+}
+
+auto PackageStore::HasVersion(const std::string& version) const -> bool {
+  return std::find(versions_.begin(), versions_.end(), version) != versions_.end();
+}
+
+auto PackageStore::LoadManifest(const std::string& version) const -> std::vector<ManifestEntry> {
+  LOG_D("PackageStore::LoadManifest(" + version + ")");
+
+  if (!HasVersion(version)) {
+    throw std::runtime_error("Version not found");
+  }
+
+  const MappedFile file(GetPath(version + ".manifest"));
+  const char* it = file.GetData();
+  const char* const end = it + file.GetSize();
+  if (file.GetSize() < kManifestMagicLength || std::memcmp(it, kManifestMagic, kManifestMagicLength) != 0) {
+    throw std::runtime_error("Manifest is corrupted");
+  }
+  it += kManifestMagicLength;
+
+  std::uint64_t count;
+  if (!ReadVarint(&it, end, &count)) {
+    throw std::runtime_error("Manifest is corrupted");
+  }
+
+  auto entries = std::vector<ManifestEntry>();
+  entries.reserve(std::min<std::uint64_t>(count, file.GetSize()));
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::uint64_t length;
+    ManifestEntry e{};
+    if (!ReadVarint(&it, end, &length) || static_cast<std::uint64_t>(end - it) < length) {
+      throw std::runtime_error("Manifest is corrupted");
+    }
+    e.name.assign(it, length);
+    it += length;
+
+    if (!ReadVarint(&it, end, &e.body_hash) || !ReadVarint(&it, end, &e.digest)) {
+      throw std::runtime_error("Manifest is corrupted");
+    }
+    entries.emplace_back(std::move(e));
+  }
+
+  return entries;
+}
+
+auto PackageStore::GetBody(std::uint64_t body_hash) const -> std::vector<std::string> {
+  auto search = bodies_.find(body_hash);
+  if (search == bodies_.end()) {
+    throw std::runtime_error("Body not found");
+  }
+
+  auto ifs = std::ifstream(GetPath("bodies.dat"), std::ios::binary);
+  ifs.seekg(static_cast<std::streamoff>(search->second.offset));
+  auto body = std::string(search->second.length, '\0');
+  ifs.read(&body[0], static_cast<std::streamsize>(body.size()));
+  if (!ifs) {
+    throw std::runtime_error("Cannot read body file");
+  }
+
+  auto lines = std::vector<std::string>();
+  for (std::string::size_type pos = 0; pos < body.size();) {
+    std::string::size_type line_end = body.find('\n', pos);
+    if (line_end == std::string::npos) {
+      line_end = body.size();
+    }
+
+    // remove trailing CR character in *nix systems
+    std::string::size_type length = line_end - pos;
+    if (length != 0 && body[line_end - 1] == '\r') {
+      --length;
+    }
+    lines.emplace_back(body, pos, length);
+    pos = line_end + 1;
+  }
+  return lines;
+}
+
+/**
+ * @brief Reads the names of all versions from the versions file.
+ */
+void PackageStore::LoadVersions() {
+  auto ifs = std::ifstream(GetPath("versions.lst"));
+
+  std::string line;
+  while (getline(ifs, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      versions_.push_back(line);
+    }
+  }
+}
+
+/**
+ * @brief Reads the location of all bodies from the body file.
+ *
+ * Reading stops at the first incomplete record, so that bodies written by an interrupted @c AddVersion are truncated
+ * away by the next one.
+ *
+ * @throw @c std::runtime_error if the body file exists but cannot be read
+ */
+void PackageStore::LoadBodies() {
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0;
+  if (!GetFileStamp(GetPath("bodies.dat"), &size, &mtime) || size == 0) {
+    return;
+  }
+
+  const MappedFile file(GetPath("bodies.dat"));
+  const char* const begin = file.GetData();
+  const char* const end = begin + file.GetSize();
+  for (const char* it = begin; it != end;) {
+    std::uint64_t hash;
+    std::uint64_t length;
+    if (!ReadVarint(&it, end, &hash) || !ReadVarint(&it, end, &length) ||
+        static_cast<std::uint64_t>(end - it) < length) {
+      LOG_W("Body file is truncated; ignoring incomplete record");
+      break;
+    }
+
+    bodies_.emplace(hash, BodyLocation{static_cast<std::uint64_t>(it - begin), length});
+    body_size_ += length;
+    it += length;
+    body_file_size_ = static_cast<std::uint64_t>(it - begin);
+  }
+}
+
+auto PackageStore::GetPath(const std::string& filename) const -> std::string {
+  return directory_ + "/" + filename;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Content-addressed store of multiple versions of Packages files.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_PACKAGE_STORE_H_
+#define WARFRAME_PACKAGES_DEPARSER_PACKAGE_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * Store of multiple versions of Packages files.
+ *
+ * Package bodies are deduplicated across versions by the hash of their raw contents, and are appended to a single
+ * body file. Each version is described by a manifest, which maps every header of the version to the hash of its
+ * body. A store directory contains the following files:
+ *
+ * - versions.lst: Names of all versions, one per line, in the order they are added
+ * - bodies.dat: All unique package bodies
+ * - <version>.manifest: Manifest of each version
+ */
+class PackageStore {
+ public:
+  /**
+   * @brief A single header of a version.
+   */
+  struct ManifestEntry {
+    /**
+     * @brief Name of the header.
+     */
+    std::string name;
+    /**
+     * @brief Hash of the raw body, which identifies the body in the store.
+     */
+    std::uint64_t body_hash;
+    /**
+     * @brief Hash of the normalized body. See @c HashPackageBody.
+     */
+    std::uint64_t digest;
+  };
+
+  /**
+   * Opens a store, creating it if it does not exist.
+   *
+   * @param directory Directory of the store
+   *
+   * @throw @c std::runtime_error if the store cannot be created or read
+   */
+  explicit PackageStore(std::string directory);
+
+  /**
+   * Adds a version to the store.
+   *
+   * For headers which are defined more than once, only the first body is stored.
+   *
+   * @param version Name of the version
+   * @param file Mapped Packages file of the version
+   * @return Number of bodies which were not in the store before
+   *
+   * @throw @c std::runtime_error if the version already exists, or the store cannot be written
+   */
+  auto AddVersion(const std::string& version, const MappedFile& file) -> std::size_t;
+
+  /**
+   * @return Names of all versions, in the order they are added
+   */
+  auto GetVersions() const -> const std::vector<std::string>& { return versions_; }
+
+  /**
+   * @param version Name of the version
+   * @return Whether the version exists in the store
+   */
+  auto HasVersion(const std::string& version) const -> bool;
+
+  /**
+   * Loads the manifest of a version.
+   *
+   * @param version Name of the version
+   * @return All headers of the version, sorted by name
+   *
+   * @throw @c std::runtime_error if the manifest cannot be read
+   */
+  auto LoadManifest(const std::string& version) const -> std::vector<ManifestEntry>;
+
+  /**
+   * Reads a body from the store.
+   *
+   * @param body_hash Hash of the raw body
+   * @return Lines of the body, without trailing CR characters
+   *
+   * @throw @c std::runtime_error if the body is not in the store
+   */
+  auto GetBody(std::uint64_t body_hash) const -> std::vector<std::string>;
+
+  /**
+   * @return Number of unique bodies in the store
+   */
+  auto GetBodyCount() const -> std::size_t { return bodies_.size(); }
+
+  /**
+   * @return Total size of all unique bodies in bytes
+   */
+  auto GetBodySize() const -> std::uint64_t { return body_size_; }
+
+ private:
+  /**
+   * @brief Location of a body in the body file.
+   */
+  struct BodyLocation {
+    std::uint64_t offset;
+    std::uint64_t length;
+  };
+
+  void LoadVersions();
+  void LoadBodies();
+
+  auto GetPath(const std::string& filename) const -> std::string;
+
+  std::string directory_;
+  std::vector<std::string> versions_;
+  std::unordered_map<std::uint64_t, BodyLocation> bodies_;
+  std::uint64_t body_size_ = 0;
+  /**
+   * @brief Size of the valid prefix of the body file, which new bodies are appended after.
+   */
+  std::uint64_t body_file_size_ = 0;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_PACKAGE_STORE_H_
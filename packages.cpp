@@ -17,9 +17,11 @@
 #include <utility>
 #include <vector>
 
+#include "allocation_tracker.h"
 #include "config_file.h"
 #include "log.h"
 #include "prettify.h"
+#include "profiler.h"
 #include "timer.h"
 #include "util.h"
 
@@ -37,6 +39,7 @@ using std::getline;
  */
 Packages::Packages(const std::string& filename, std::ifstream&& ifs, std::string&& prettify_filename)
     : ifs_(std::move(ifs)), filename_(filename), headers_(std::map<std::string, unsigned>()) {
+  PROFILE_ZONE("Packages::Packages");
   if (!ifs_) {
     throw std::runtime_error("Cannot open file");
   }
@@ -46,18 +49,71 @@ Packages::Packages(const std::string& filename, std::ifstream&& ifs, std::string
 
   ParseFile(&ifs_);
 
-  // replace with default path if no file is specified for prettify
-  if (prettify_filename.empty()) {
-    Log::d("No prettify file specified. Using default path.");
-    prettify_filename = "prettify.txt";
+  ReloadPrettify(prettify_filename);
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+
+  LOG_I("Initialization of Packages(\"" + filename_ + "\") complete. Took " + std::to_string(time) + "ms.");
+}
+
+Packages::~Packages() = default;
+
+/**
+ * @brief Reads a prettify file and replaces the current prettifier with it.
+ *
+ * Threads which are prettifying using the previous prettifier are unaffected, and continue to use it until they
+ * call @c GetPrettifier again.
+ *
+ * @param prettify_filename Prettify filename. If empty, the previous prettify file is read again, or the built-in
+ * prettify tables are used if no prettify file has been read.
+ */
+void Packages::ReloadPrettify(const std::string& prettify_filename) {
+  if (!prettify_filename.empty()) {
+    prettify_filename_ = prettify_filename;
   }
 
-  Log::i("Using prettify source \"" + prettify_filename + "\"");
+  std::shared_ptr<const Prettifier> prettifier = nullptr;
+  if (prettify_filename_.empty()) {
+    LOG_I("Using built-in prettify tables");
+    prettifier = std::make_shared<const Prettifier>();
+  } else {
+    LOG_I("Using prettify source \"" + prettify_filename_ + "\"");
+    prettifier = std::make_shared<const Prettifier>(prettify_filename_);
+  }
+  std::atomic_store(&prettifier_, std::move(prettifier));
+}
 
-  ParsePrettify(prettify_filename);
+/**
+ * @brief Retrieves the current prettifier.
+ *
+ * @return Current prettifier, which stays valid even if it is replaced afterwards
+ */
+auto Packages::GetPrettifier() const -> std::shared_ptr<const Prettifier> { return std::atomic_load(&prettifier_); }
 
-  t.Stop();
-  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+/**
+ * @brief Outputs runtime statistics.
+ *
+ * @param is_memory Whether to also output the heap allocations of each profiled zone
+ */
+void Packages::OutputStats(bool is_memory) const {
+  const Prettifier::MemoStats memo_stats = GetPrettifier()->GetMemoStats();
+  const std::uint64_t lookups = memo_stats.hits + memo_stats.misses;
+
+  cout << "Prettify memo table: " << memo_stats.hits << " hits, " << memo_stats.misses << " misses";
+  if (lookups != 0) {
+    cout << " (" << memo_stats.hits * 100 / lookups << "% hit rate)";
+  }
+  cout << endl;
+
+  if (is_memory) {
+    if (AllocationTracker::IsEnabled()) {
+      cout << endl;
+      Profiler::OutputAllocationReport(cout);
+    } else {
+      cout << "Allocation tracking is disabled. Launch with --track-allocations to enable it." << endl;
+    }
+  }
 
-  Log::i("Initialization of Packages(\"" + filename_ + "\") complete. Took " + std::to_string(time) + "ms.");
+  Log::FlushFileBuf();
 }
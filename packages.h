@@ -7,11 +7,19 @@
 #ifndef WARFRAME_PACKAGES_DEPARSER_PACKAGES_H_
 #define WARFRAME_PACKAGES_DEPARSER_PACKAGES_H_
 
+#include <cstdint>
 #include <fstream>
+#include <istream>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "search_index.h"
+
+class PackageStore;
+class Prettifier;
+
 class Packages {
  public:
   enum struct SortOptions : unsigned {
@@ -41,16 +49,40 @@ class Packages {
   };
 
   Packages(const std::string& filename, std::ifstream&& ifs, std::string&& prettify_filename = "");
+  ~Packages();
+
+  void ReloadPrettify(const std::string& prettify_filename);
+  auto GetPrettifier() const -> std::shared_ptr<const Prettifier>;
+
+  void OutputStats(bool is_memory = false) const;
 
   void OutputHeader(const std::string& header, bool is_raw);
 
   void Find(std::string&& header, bool search_front, unsigned max_size);
+  void FuzzyFind(std::string&& query, unsigned max_results);
+  void Search(std::vector<std::string>&& terms, bool rebuild);
+  void Grep(const std::string& pattern, bool is_regex, bool show_lines);
 
   void Compare(const std::string& cmp_filename);
+  void CompareMany(const std::vector<std::string>& filenames, bool show_all);
+  void Diff(const std::string& header, const std::string& cmp_filename, bool as_json);
+  void DiffAll(const std::string& cmp_filename, bool as_json);
+  void UnifiedDiff(const std::string& cmp_filename, const std::string& outfile, unsigned context);
+
+  void StoreAdd(PackageStore* store, const std::string& version, const std::string& filename);
+  void StoreList(const PackageStore& store);
+  void StoreHistory(const PackageStore& store, const std::string& header);
+  void StoreCompare(const PackageStore& store, const std::vector<std::string>& versions);
+  void OutputStoredHeader(const PackageStore& store, const std::string& version, const std::string& header,
+                          bool is_raw);
 
   void SortFile(const std::string& outfile, unsigned opt_mask, unsigned notify_count);
 
   void ReverseLookup(unsigned line, bool is_interactive);
+  void ReverseLookupBatch(std::istream& is);
+
+  auto GetLines(unsigned first, unsigned count) -> std::vector<std::string>;
+  void OutputLines(unsigned from, unsigned to);
 
   std::vector<std::string> HeaderToJson(const std::string& header, StructureOptions opts, std::vector<std::string>&& read_file);
   void DumpJson(std::string&& outfile, unsigned notify_count);
@@ -59,13 +91,59 @@ class Packages {
   auto GetSize() const -> std::size_t { return headers_.size(); }
 
  private:
+  /**
+   * @brief Number of lines between two line checkpoints.
+   */
+  static constexpr unsigned kLineCheckpointInterval = 1024;
+
+  /**
+   * @brief Location of a header in the file.
+   */
+  struct HeaderLocation {
+    /**
+     * @brief Byte offset of the header line.
+     */
+    std::uint64_t offset;
+    /**
+     * @brief Zero-based line number of the header line.
+     */
+    unsigned line;
+    /**
+     * @brief Name of the header, owned by @c headers_.
+     */
+    const std::string* name;
+  };
+
   void ParseFile(std::ifstream* ifs);
+  void ComputeDigests();
 
   auto GetHeaderContents(const std::string& header, bool inc_header = false) -> std::vector<std::string>;
+  auto GetHeaderAtLine(unsigned line) const -> const HeaderLocation*;
+  void SeekToLine(std::ifstream& fs, unsigned line) const;
+  void LoadSearchIndex(bool rebuild);
 
   std::ifstream ifs_;
   std::string filename_ = "";
   std::map<std::string, unsigned> headers_;
+  std::vector<const std::string*> header_names_;
+  /**
+   * @brief Hash of the normalized body of each header, in the same order as @c header_names_. Only valid if
+   * @c is_digests_computed_ is set.
+   */
+  std::vector<std::uint64_t> header_hashes_;
+  bool is_digests_computed_ = false;
+  std::vector<HeaderLocation> header_locations_;
+  unsigned line_count_ = 0;
+  std::vector<std::uint64_t> line_checkpoints_;
+
+  std::unique_ptr<SearchIndex> search_index_ = nullptr;
+
+  std::string prettify_filename_ = "";
+  /**
+   * @brief Current prettifier. Only accessed through @c std::atomic_load and @c std::atomic_store, so that it can be
+   * replaced while other threads are prettifying.
+   */
+  std::shared_ptr<const Prettifier> prettifier_ = nullptr;
 };
 
 #endif  // WARFRAME_PACKAGES_DEPARSER_PACKAGES_H_
@@ -6,12 +6,14 @@
 
 #include "packages.h"
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include "log.h"
 #include "prettify.h"
+#include "profiler.h"
 #include "timer.h"
 #include "util.h"
 
@@ -26,7 +28,8 @@ using std::endl;
  * @param notify_count How often to output progress
  */
 void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned notify_count) {
-  Log::i("Packages::SortFile -> " + outfile);
+  PROFILE_ZONE("Packages::SortFile");
+  LOG_I("Packages::SortFile -> " + outfile);
 
   // initialize variables
   auto instream = std::ifstream(filename_);
@@ -35,7 +38,7 @@ void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned
 
   cout << "Loading file, please wait..." << endl;
 
-  Log::d("Begin full file load");
+  LOG_D("Begin full file load");
 
   Timer t;
   t.Start();
@@ -43,7 +46,9 @@ void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned
   // re-read the whole file into RAM
   std::string category;
   std::string buffer_line;
+  std::uint64_t bytes_read = 0;
   for (auto i = 0; getline(instream, buffer_line); ++i) {
+    bytes_read += buffer_line.size() + 1;
     if (buffer_line.empty()) {
       continue;
     }
@@ -73,9 +78,11 @@ void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned
     }
   }
 
+  Profiler::AddBytes(bytes_read);
+
   t.Stop();
   auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
-  Log::d("Read complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Read complete. Took " + std::to_string(time) + "ms.");
   t.Reset();
 
   instream.close();
@@ -83,18 +90,19 @@ void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned
   unsigned count{0};
   const auto total = contents.size();
 
-  Log::d("Begin full file dump");
+  LOG_D("Begin full file dump");
 
   t.Start();
 
   // dump map into new file
+  const auto prettifier = GetPrettifier();
   for (auto&& p : contents) {
     if (++count % notify_count == 0) {
       cout << "Dumping header: " << count << "/" << total << endl;
     }
     for (auto&& l : p.second) {
       if (opt_mask & static_cast<unsigned>(SortOptions::kPrettify)) {
-        PrettifyLine(l);
+        prettifier->PrettifyLine(l);
       }
 
       outstream << l << '\n';
@@ -104,7 +112,7 @@ void Packages::SortFile(const std::string& outfile, unsigned opt_mask, unsigned
 
   t.Stop();
   time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
-  Log::d("Dump complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Dump complete. Took " + std::to_string(time) + "ms.");
 
   outstream.close();
   Log::FlushFileBuf();
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "log.h"
+#include "profiler.h"
 #include "timer.h"
 #include "util.h"
 
@@ -27,7 +28,8 @@ using std::endl;
  * @param notify_count How often to output progress
  */
 void Packages::DumpJson(std::string&& outfile, unsigned notify_count) {
-  Log::i("Packages::DumpJson -> " + outfile);
+  PROFILE_ZONE("Packages::DumpJson");
+  LOG_I("Packages::DumpJson -> " + outfile);
 
   // initialize variables
   auto instream = std::ifstream(filename_);
@@ -36,7 +38,7 @@ void Packages::DumpJson(std::string&& outfile, unsigned notify_count) {
 
   cout << "Loading file, please wait..." << endl;
 
-  Log::d("Begin full file load");
+  LOG_D("Begin full file load");
 
   Timer t;
   t.Start();
@@ -70,7 +72,7 @@ void Packages::DumpJson(std::string&& outfile, unsigned notify_count) {
 
   t.Stop();
   auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
-  Log::d("Read complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Read complete. Took " + std::to_string(time) + "ms.");
   t.Reset();
 
   instream.close();
@@ -79,7 +81,7 @@ void Packages::DumpJson(std::string&& outfile, unsigned notify_count) {
   unsigned failcount{0};
   const auto total = contents.size();
 
-  Log::d("Begin full file dump");
+  LOG_D("Begin full file dump");
 
   t.Start();
 
@@ -102,10 +104,10 @@ void Packages::DumpJson(std::string&& outfile, unsigned notify_count) {
 
   t.Stop();
   time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
-  Log::d("Json dump complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Json dump complete. Took " + std::to_string(time) + "ms.");
   if (failcount != 0) {
     std::cerr << "Completed with " << failcount << " ignored packages." << std::endl;
-    Log::w("Json dump resulted in " + std::to_string(failcount) + "errors.");
+    LOG_W("Json dump resulted in " + std::to_string(failcount) + "errors.");
   }
 
   outstream.close();
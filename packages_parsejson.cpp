@@ -10,6 +10,8 @@
 #include <string>
 #include <vector>
 
+#include "profiler.h"
+
 using std::cout;
 using std::endl;
 
@@ -117,6 +119,7 @@ void OutputTree(Type t, const unsigned indent, const std::string& key) {
 std::vector<std::string> Packages::HeaderToJson(const std::string& header,
                                                 StructureOptions opts,
                                                 std::vector<std::string>&& read_file) {
+  PROFILE_ZONE("Packages::HeaderToJson");
   if (headers_.find(header) == headers_.end()) {
     cout << "Cannot find header." << endl;
     return std::vector<std::string>();
@@ -0,0 +1,264 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for package store functions of Packages class.
+//
+
+#include "packages.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "mapped_file.h"
+#include "package_store.h"
+#include "prettify.h"
+#include "profiler.h"
+#include "timer.h"
+#include "util.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+/**
+ * @brief Finds a header in a manifest.
+ *
+ * @param manifest Manifest sorted by name
+ * @param header Name of the header
+ * @return Pointer to the entry, or @c nullptr if the header is not in the manifest
+ */
+auto FindManifestEntry(const std::vector<PackageStore::ManifestEntry>& manifest, const std::string& header)
+    -> const PackageStore::ManifestEntry* {
+  auto it = std::lower_bound(manifest.begin(), manifest.end(), header,
+                             [](const PackageStore::ManifestEntry& e, const std::string& h) { return e.name < h; });
+  return it != manifest.end() && it->name == header ? &*it : nullptr;
+}
+}  // namespace
+
+/**
+ * @brief Adds a Packages file to the package store as a new version.
+ *
+ * @param store Package store
+ * @param version Name of the version
+ * @param filename Filename of the Packages file
+ */
+void Packages::StoreAdd(PackageStore* const store, const std::string& version, const std::string& filename) {
+  PROFILE_ZONE("Packages::StoreAdd");
+  LOG_I("Packages::StoreAdd(" + version + "): " + filename);
+
+  Timer t;
+  t.Start();
+
+  std::size_t new_count;
+  try {
+    const MappedFile file(filename);
+    new_count = store->AddVersion(version, file);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
+    cout << version << ": " << ex_runtime.what() << "." << endl;
+    return;
+  }
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  LOG_D("Version added. Took " + std::to_string(time) + "ms.");
+
+  cout << "Added " << filename << " as version " << version << ". " << new_count << " new package bodies." << endl;
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Lists all versions in the package store.
+ *
+ * @param store Package store
+ */
+void Packages::StoreList(const PackageStore& store) {
+  LOG_I("Packages::StoreList()");
+
+  for (auto&& v : store.GetVersions()) {
+    try {
+      cout << v << '\t' << store.LoadManifest(v).size() << " packages" << '\n';
+    } catch (std::runtime_error& ex_runtime) {
+      cout << v << '\t' << ex_runtime.what() << '\n';
+    }
+  }
+  cout << endl;
+  cout << store.GetVersions().size() << " versions, " << store.GetBodyCount() << " unique package bodies ("
+       << store.GetBodySize() << " bytes)." << endl;
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Shows how a header changed across all versions in the package store.
+ *
+ * @param store Package store
+ * @param header Name of the header
+ */
+void Packages::StoreHistory(const PackageStore& store, const std::string& header) {
+  LOG_I("Packages::StoreHistory(" + header + ")");
+
+  bool is_present = false;
+  std::uint64_t last_digest = 0;
+  unsigned change_count = 0;
+  for (auto&& v : store.GetVersions()) {
+    auto manifest = std::vector<PackageStore::ManifestEntry>();
+    try {
+      manifest = store.LoadManifest(v);
+    } catch (std::runtime_error& ex_runtime) {
+      cout << v << '\t' << ex_runtime.what() << '\n';
+      continue;
+    }
+
+    // only versions where the header changes are shown
+    const PackageStore::ManifestEntry* entry = FindManifestEntry(manifest, header);
+    if (entry == nullptr) {
+      if (is_present) {
+        cout << v << "\tremoved" << '\n';
+        ++change_count;
+      }
+      is_present = false;
+    } else if (!is_present) {
+      cout << v << "\tadded" << '\n';
+      ++change_count;
+      is_present = true;
+      last_digest = entry->digest;
+    } else if (entry->digest != last_digest) {
+      cout << v << "\tmodified" << '\n';
+      ++change_count;
+      last_digest = entry->digest;
+    }
+  }
+
+  cout << endl;
+  if (change_count == 0) {
+    cout << header << ": Header not found in any version." << endl;
+  } else {
+    cout << change_count << " changes across " << store.GetVersions().size() << " versions." << endl;
+  }
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Compares the headers and contents between consecutive versions in the package store.
+ *
+ * @param store Package store
+ * @param versions Names of the versions to compare, from oldest to newest
+ */
+void Packages::StoreCompare(const PackageStore& store, const std::vector<std::string>& versions) {
+  PROFILE_ZONE("Packages::StoreCompare");
+  LOG_I("Packages::StoreCompare(" + JoinToString(versions, " ") + ")");
+
+  auto prev = std::vector<PackageStore::ManifestEntry>();
+  for (std::size_t v = 0; v < versions.size(); ++v) {
+    auto next = std::vector<PackageStore::ManifestEntry>();
+    try {
+      next = store.LoadManifest(versions[v]);
+    } catch (std::runtime_error& ex_runtime) {
+      cout << versions[v] << ": " << ex_runtime.what() << "." << endl;
+      return;
+    }
+
+    if (v != 0) {
+      auto has_added = std::vector<std::string>();
+      auto has_removed = std::vector<std::string>();
+      auto has_modified = std::vector<std::string>();
+
+      // both manifests are sorted, so they can be compared by a single merge pass
+      std::size_t i = 0;
+      std::size_t j = 0;
+      while (i < next.size() || j < prev.size()) {
+        if (j == prev.size() || (i < next.size() && next[i].name < prev[j].name)) {
+          has_added.emplace_back(next[i++].name);
+        } else if (i == next.size() || prev[j].name < next[i].name) {
+          has_removed.emplace_back(prev[j++].name);
+        } else {
+          if (next[i].digest != prev[j].digest) {
+            has_modified.emplace_back(next[i].name);
+          }
+          ++i;
+          ++j;
+        }
+      }
+
+      cout << versions[v - 1] << " -> " << versions[v] << ": " << has_added.size() << " additions, "
+           << has_removed.size() << " deletions, " << has_modified.size() << " modifications" << '\n';
+      for (auto&& h : has_added) {
+        cout << "  + " << h << '\n';
+      }
+      for (auto&& h : has_removed) {
+        cout << "  - " << h << '\n';
+      }
+      for (auto&& h : has_modified) {
+        cout << "  ~ " << h << '\n';
+      }
+      cout << endl;
+    }
+
+    prev = std::move(next);
+  }
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Output a header from a version in the package store.
+ *
+ * @param store Package store
+ * @param version Name of the version
+ * @param header Header to dump
+ * @param is_raw Whether to show the raw version as opposed to the prettified version
+ */
+void Packages::OutputStoredHeader(const PackageStore& store, const std::string& version, const std::string& header,
+                                  bool is_raw) {
+  PROFILE_ZONE("Packages::OutputStoredHeader");
+  std::vector<std::string> contents;
+  try {
+    const auto manifest = store.LoadManifest(version);
+    const PackageStore::ManifestEntry* entry = FindManifestEntry(manifest, header);
+    if (entry == nullptr) {
+      cout << header << ": Header not found in version " << version << "." << endl;
+      return;
+    }
+    contents = store.GetBody(entry->body_hash);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
+    cout << version << ": " << ex_runtime.what() << "." << endl;
+    return;
+  }
+
+  ClearScreen();
+
+  LOG_V("Dumping data for " + header + " in version " + version);
+  cout << "Package Name: " << header << endl;
+  if (!is_raw && !contents.empty() && contents[0].find("BasePackage=") != std::string::npos) {
+    cout << "Base Package: " << contents[0].substr(contents[0].find("BasePackage=") + 12) << endl;
+    contents.erase(contents.begin());
+  }
+  if (!is_raw) {
+    cout << endl;
+  }
+  cout << "Version: " << version << endl;
+  cout << endl;
+
+  // display the contents
+  const auto prettifier = GetPrettifier();
+  for (auto& it : contents) {
+    ConvertTabToSpace(it);
+    if (!is_raw) {
+      prettifier->PrettifyLine(it);
+    }
+
+    cout << it << endl;
+  }
+
+  LOG_V("Data dump complete");
+  Log::FlushFileBuf();
+}
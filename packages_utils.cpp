@@ -6,30 +6,48 @@
 
 #include "packages.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "log.h"
+#include "mapped_file.h"
+#include "package_digest.h"
+#include "profiler.h"
+#include "search_index.h"
+#include "timer.h"
 #include "util.h"
 
 using std::cout;
 using std::endl;
 
 /**
- * @brief Parses the input file, saves all headers and their corresponding line number.
+ * @brief Parses the input file, saves all headers and their corresponding line number and byte offset.
  *
  * @param ifs Input file stream
  */
 void Packages::ParseFile(std::ifstream* const ifs) {
-  Log::d("Packages::ParseFile");
+  PROFILE_ZONE("Packages::ParseFile");
+  LOG_D("Packages::ParseFile");
 
   cout << "Reading file, please wait..." << endl;
   std::string buffer_line;
+  std::uint64_t offset = 0;
 
   // read file and save with line numbers
   for (unsigned i = 0; getline(*ifs, buffer_line); ++i) {
+    const std::uint64_t line_offset = offset;
+    offset += buffer_line.size() + 1;
+    line_count_ = i + 1;
+
+    if (i % kLineCheckpointInterval == 0) {
+      line_checkpoints_.push_back(line_offset);
+    }
+
     if (buffer_line.empty()) {
       continue;
     }
@@ -42,9 +60,156 @@ void Packages::ParseFile(std::ifstream* const ifs) {
     auto start_of_category = buffer_line.find("FullPackageName=");
     if (start_of_category != std::string::npos) {
       std::string category = buffer_line.substr(start_of_category + 16);
-      headers_.emplace(category, i);
+      auto it = headers_.emplace(category, i).first;
+      header_locations_.push_back({line_offset, i, &it->first});
+    }
+  }
+
+  Profiler::AddBytes(offset);
+
+  // keep a random-access view of all header names for parallel searches
+  header_names_.clear();
+  header_names_.reserve(headers_.size());
+  for (auto&& p : headers_) {
+    header_names_.emplace_back(&p.first);
+  }
+}
+
+/**
+ * @brief Computes the hash of the body of every header in parallel, unless they have already been computed.
+ *
+ * The hashes are only needed for comparing against other files, so they are computed on first use rather than when
+ * the file is loaded.
+ *
+ * @throw @c std::runtime_error if the file cannot be read
+ */
+void Packages::ComputeDigests() {
+  if (is_digests_computed_) {
+    return;
+  }
+
+  PROFILE_ZONE("Packages::ComputeDigests");
+  LOG_D("Packages::ComputeDigests");
+
+  Timer t;
+  t.Start();
+
+  const MappedFile file(filename_);
+  const char* const data = file.GetData();
+  const char* const data_end = data + file.GetSize();
+  Profiler::AddBytes(file.GetSize());
+
+  // hash the body of each header location, which spans from the line after the header to the next header
+  auto location_hashes = std::vector<std::uint64_t>(header_locations_.size());
+  ParallelChunks(header_locations_.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+    std::string buffer;
+    for (std::size_t i = begin; i < end; ++i) {
+      const char* header_line = data + std::min<std::uint64_t>(header_locations_[i].offset, file.GetSize());
+      const char* body_end = i + 1 < header_locations_.size()
+                             ? data + std::min<std::uint64_t>(header_locations_[i + 1].offset, file.GetSize())
+                             : data_end;
+      const char* body_begin = std::find(header_line, body_end, '\n');
+      if (body_begin != body_end) {
+        ++body_begin;
+      }
+
+      location_hashes[i] = HashPackageBody(body_begin, body_end, &buffer);
     }
+  });
+
+  // headers which are defined more than once combine the hashes of all their bodies
+  header_hashes_.assign(header_names_.size(), 0);
+  auto is_hashed = std::vector<bool>(header_names_.size(), false);
+  for (std::size_t i = 0; i < header_locations_.size(); ++i) {
+    auto it = std::lower_bound(header_names_.begin(), header_names_.end(), *header_locations_[i].name,
+                               [](const std::string* a, const std::string& b) { return *a < b; });
+    const auto id = static_cast<std::size_t>(it - header_names_.begin());
+
+    header_hashes_[id] = is_hashed[id] ? CombineBodyHash(header_hashes_[id], location_hashes[i]) : location_hashes[i];
+    is_hashed[id] = true;
   }
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  is_digests_computed_ = true;
+  LOG_D("Digest computation complete. Took " + std::to_string(time) + "ms.");
+}
+
+/**
+ * @brief Finds the header which a line belongs to.
+ *
+ * @param line Zero-based line number
+ * @return Location of the owning header, or @c nullptr if the line does not belong to any header
+ */
+auto Packages::GetHeaderAtLine(unsigned line) const -> const HeaderLocation* {
+  if (line >= line_count_) {
+    return nullptr;
+  }
+
+  // header locations are sorted by line number, as they are saved in the order they appear in the file
+  auto it = std::upper_bound(header_locations_.begin(), header_locations_.end(), line,
+                             [](unsigned l, const HeaderLocation& h) { return l < h.line; });
+  if (it == header_locations_.begin()) {
+    return nullptr;
+  }
+
+  return &*(it - 1);
+}
+
+/**
+ * @brief Jumps to a certain line in an open @c std::ifstream of the input file.
+ *
+ * This seeks to the nearest line checkpoint before the line, so at most @c kLineCheckpointInterval lines are skipped.
+ *
+ * @param fs Input file stream, opened in binary mode
+ * @param line Zero-based line number
+ */
+void Packages::SeekToLine(std::ifstream& fs, unsigned line) const {
+  fs.clear();
+  if (line_checkpoints_.empty()) {
+    fs.seekg(0);
+    return;
+  }
+
+  const std::size_t checkpoint = std::min<std::size_t>(line / kLineCheckpointInterval, line_checkpoints_.size() - 1);
+  fs.seekg(static_cast<std::streamoff>(line_checkpoints_[checkpoint]));
+
+  // skip the remaining lines after the checkpoint
+  for (auto it = static_cast<unsigned>(checkpoint * kLineCheckpointInterval); it < line; ++it) {
+    fs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+}
+
+/**
+ * @brief Retrieves a range of lines from the file.
+ *
+ * @param first Zero-based line number of the first line
+ * @param count Number of lines to retrieve
+ * @return Retrieved lines, which may be fewer than @p count at the end of the file
+ */
+auto Packages::GetLines(unsigned first, unsigned count) -> std::vector<std::string> {
+  PROFILE_ZONE("Packages::GetLines");
+  LOG_D("Packages::GetLines(" + std::to_string(first) + ", " + std::to_string(count) + ")");
+
+  auto content = std::vector<std::string>();
+  if (first >= line_count_) {
+    return content;
+  }
+
+  auto fs = std::ifstream(filename_, std::ios::binary);
+  SeekToLine(fs, first);
+
+  std::string line;
+  for (unsigned it = 0; it < count && getline(fs, line); ++it) {
+    // remove trailing CR character in *nix systems
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    content.push_back(line);
+  }
+
+  return content;
 }
 
 /**
@@ -56,27 +221,28 @@ void Packages::ParseFile(std::ifstream* const ifs) {
  * @return All lines of the given header
  */
 auto Packages::GetHeaderContents(const std::string& header, bool inc_header) -> std::vector<std::string> {
-  Log::d("Packages::GetHeaderContents(" + header + ")");
+  PROFILE_ZONE("Packages::GetHeaderContents");
+  LOG_D("Packages::GetHeaderContents(" + header + ")");
 
   auto content = std::vector<std::string>();
 
   auto search = headers_.find(header);
   if (search == headers_.end()) {
-    Log::w("Cannot find header!");
+    LOG_W("Cannot find header!");
     return content;
   }
 
   unsigned index = search->second + 1 + static_cast<unsigned>(!inc_header);
 
-  Log::v("Packages::GetHeaderContents: Will start reading from line " + std::to_string(index));
+  LOG_V("Packages::GetHeaderContents: Will start reading from line " + std::to_string(index));
 
-  auto fs = std::ifstream(filename_);
-  GotoLine(fs, index);
+  auto fs = std::ifstream(filename_, std::ios::binary);
+  SeekToLine(fs, index - 1);
 
   std::string line;
   for (unsigned it = index; getline(fs, line); ++it) {
     if (it != index && line.find("FullPackageName=") != std::string::npos) {
-      Log::v("Packages::GetHeaderContents: Next header found. Breaking.");
+      LOG_V("Packages::GetHeaderContents: Next header found. Breaking.");
       break;
     }
 
@@ -92,3 +258,36 @@ auto Packages::GetHeaderContents(const std::string& header, bool inc_header) ->
   return content;
 }
 
+/**
+ * @brief Loads the search index from its sidecar file, or builds and saves it if the sidecar file is stale.
+ *
+ * @param rebuild If true, always rebuild the search index
+ *
+ * @throw @c std::runtime_error if the file cannot be read
+ */
+void Packages::LoadSearchIndex(bool rebuild) {
+  PROFILE_ZONE("Packages::LoadSearchIndex");
+  LOG_D("Packages::LoadSearchIndex");
+
+  const std::string index_filename = filename_ + ".idx";
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0;
+  const bool has_stamp = GetFileStamp(filename_, &size, &mtime);
+
+  if (!rebuild && has_stamp) {
+    search_index_ = SearchIndex::Load(index_filename, size, mtime, header_names_.size());
+    if (search_index_ != nullptr) {
+      LOG_I("Loaded search index from \"" + index_filename + "\"");
+      return;
+    }
+  }
+
+  cout << "Building search index, please wait..." << endl;
+
+  const MappedFile file(filename_);
+  search_index_ = SearchIndex::Build(file, header_names_);
+
+  if (!has_stamp || !search_index_->Save(index_filename, size, mtime)) {
+    LOG_W("Unable to save search index to \"" + index_filename + "\"");
+  }
+}
@@ -7,12 +7,29 @@
 #include "packages.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "fuzzy_match.h"
 #include "log.h"
+#include "mapped_file.h"
+#include "myers_diff.h"
+#include "package_diff.h"
+#include "package_digest.h"
 #include "prettify.h"
+#include "profiler.h"
+#include "text_search.h"
 #include "timer.h"
 #include "util.h"
 
@@ -27,6 +44,7 @@ using std::endl;
  * @param is_raw Whether to output the contents in the raw format
  */
 void Packages::OutputHeader(const std::string& header, bool is_raw) {
+  PROFILE_ZONE("Packages::OutputHeader");
   // find the header. return if we can't find it
   auto search = headers_.find(header);
   if (search == headers_.end()) {
@@ -41,7 +59,7 @@ void Packages::OutputHeader(const std::string& header, bool is_raw) {
   std::vector<std::string> contents = GetHeaderContents(header);
   ClearScreen();
 
-  Log::v("Dumping data for " + header);
+  LOG_V("Dumping data for " + header);
   if (is_raw) {
     // provide some raw information
     cout << "Package Name: " << header << endl;
@@ -64,14 +82,48 @@ void Packages::OutputHeader(const std::string& header, bool is_raw) {
     cout << endl;
 
     // display the contents
+    const auto prettifier = GetPrettifier();
     for (auto& it : contents) {
-      PrettifyLine(it);
+      prettifier->PrettifyLine(it);
 
       cout << it << endl;
     }
   }
 
-  Log::v("Data dump complete");
+  LOG_V("Data dump complete");
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Outputs a range of lines of the file.
+ *
+ * @param from One-based line number of the first line
+ * @param to One-based line number of the last line
+ */
+void Packages::OutputLines(unsigned from, unsigned to) {
+  PROFILE_ZONE("Packages::OutputLines");
+  if (from == 0 || to < from || from > line_count_) {
+    cout << "Invalid line range: " << from << " to " << to << endl;
+    return;
+  }
+
+  Timer t;
+  t.Start();
+
+  std::vector<std::string> lines = GetLines(from - 1, to - from + 1);
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::microseconds>(t.GetRawTime()).count());
+
+  LOG_D("Line retrieval complete. Took " + std::to_string(time) + "us.");
+
+  unsigned line_number = from;
+  for (auto&& l : lines) {
+    ConvertTabToSpace(l);
+    cout << line_number++ << ": " << l << '\n';
+  }
+  cout.flush();
+
   Log::FlushFileBuf();
 }
 
@@ -83,10 +135,11 @@ void Packages::OutputHeader(const std::string& header, bool is_raw) {
  * @param max_size Maximum matches before the application prompts the user for input.
  */
 void Packages::Find(std::string&& header, bool search_front, unsigned max_size) {
+  PROFILE_ZONE("Packages::Find");
   std::transform(header.begin(), header.end(), header.begin(), ::tolower);
   auto matches = std::vector<std::string>();
 
-  Log::d("Start search for \"" + header + "\" in header substrings");
+  LOG_D("Start search for \"" + header + "\" in header substrings");
 
   Timer t;
   t.Start();
@@ -105,8 +158,8 @@ void Packages::Find(std::string&& header, bool search_front, unsigned max_size)
   t.Stop();
   auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
 
-  Log::d("Search complete. Took " + std::to_string(time) + "ms.");
-  Log::d("Found " + std::to_string(matches.size()) + " matches.");
+  LOG_D("Search complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Found " + std::to_string(matches.size()) + " matches.");
 
   // check if we have more matches than max_size
   if (matches.size() > max_size) {
@@ -114,7 +167,7 @@ void Packages::Find(std::string&& header, bool search_front, unsigned max_size)
     std::string response;
     getline(cin, response);
     if (response != "y" && response != "Y") {
-      Log::i("Skip displaying matches from user input");
+      LOG_I("Skip displaying matches from user input");
       Log::FlushFileBuf();
       return;
     }
@@ -130,49 +183,327 @@ void Packages::Find(std::string&& header, bool search_front, unsigned max_size)
   Log::FlushFileBuf();
 }
 
+/**
+ * @brief Find the headers which are closest to the given string by edit distance.
+ *
+ * @param query String to match
+ * @param max_results Maximum number of matches to display
+ */
+void Packages::FuzzyFind(std::string&& query, unsigned max_results) {
+  PROFILE_ZONE("Packages::FuzzyFind");
+  using Match = std::pair<unsigned, const std::string*>;
+
+  LOG_D("Start fuzzy search for \"" + query + "\" in header substrings");
+
+  Timer t;
+  t.Start();
+
+  const FuzzyMatcher matcher(query);
+  const auto compare = [](const Match& a, const Match& b) {
+    if (a.first != b.first) {
+      return a.first < b.first;
+    }
+    if (a.second->size() != b.second->size()) {
+      return a.second->size() < b.second->size();
+    }
+    return *a.second < *b.second;
+  };
+
+  // score each chunk of headers on its own thread, and only keep the best matches of each chunk
+  auto chunk_matches = std::vector<std::vector<Match>>(GetWorkerCount());
+  ParallelChunks(header_names_.size(), [&](std::size_t begin, std::size_t end, unsigned worker) {
+    auto& matches = chunk_matches[worker];
+    matches.reserve(end - begin);
+    for (std::size_t i = begin; i < end; ++i) {
+      matches.emplace_back(matcher.Distance(*header_names_[i]), header_names_[i]);
+    }
+
+    if (matches.size() > max_results) {
+      std::nth_element(matches.begin(), matches.begin() + max_results, matches.end(), compare);
+      matches.resize(max_results);
+    }
+  });
+
+  auto matches = std::vector<Match>();
+  for (auto&& c : chunk_matches) {
+    matches.insert(matches.end(), c.begin(), c.end());
+  }
+  std::sort(matches.begin(), matches.end(), compare);
+  if (matches.size() > max_results) {
+    matches.resize(max_results);
+  }
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+
+  LOG_D("Fuzzy search complete. Took " + std::to_string(time) + "ms.");
+
+  // display all matches with their distance
+  for (auto&& m : matches) {
+    cout << "[" << m.first << "] " << *m.second << '\n';
+  }
+  cout << endl;
+  cout << matches.size() << " entries." << endl;
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Find all packages whose contents contain all the given terms.
+ *
+ * @param terms Tokens or key-value pairs to match. Terms ending with @c * match by prefix.
+ * @param rebuild If true, rebuild the search index before searching
+ */
+void Packages::Search(std::vector<std::string>&& terms, bool rebuild) {
+  PROFILE_ZONE("Packages::Search");
+  LOG_D("Start search for \"" + JoinToString(terms, " ") + "\" in package contents");
+
+  if (search_index_ == nullptr || rebuild) {
+    try {
+      LoadSearchIndex(rebuild);
+    } catch (std::runtime_error& ex_runtime) {
+      LOG_E("Unable to load search index: " + std::string(ex_runtime.what()));
+      cout << "Unable to load search index: " << ex_runtime.what() << endl;
+      return;
+    }
+  }
+
+  Timer t;
+  t.Start();
+
+  const std::vector<std::uint32_t> matches = search_index_->Search(terms);
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::microseconds>(t.GetRawTime()).count());
+
+  LOG_D("Search complete. Took " + std::to_string(time) + "us.");
+  LOG_D("Found " + std::to_string(matches.size()) + " matches.");
+
+  // display all matches and total count
+  for (auto&& id : matches) {
+    cout << *header_names_[id] << '\n';
+  }
+  cout << endl;
+  cout << matches.size() << " entries." << endl;
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Find all packages which contain a line matching the given pattern.
+ *
+ * @param pattern Literal string or regular expression to match
+ * @param is_regex If true, treat the pattern as an ECMAScript regular expression
+ * @param show_lines If true, also display the line number and contents of all matching lines
+ */
+void Packages::Grep(const std::string& pattern, bool is_regex, bool show_lines) {
+  PROFILE_ZONE("Packages::Grep");
+  LOG_D("Start grep for \"" + pattern + "\" in file contents");
+
+  std::unique_ptr<MappedFile> file;
+  std::regex re;
+  try {
+    file = std::make_unique<MappedFile>(filename_);
+    if (is_regex) {
+      re = std::regex(pattern);
+    }
+  } catch (std::regex_error& ex_regex) {
+    cout << pattern << ": Invalid regular expression: " << ex_regex.what() << endl;
+    return;
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E("Unable to read file: " + std::string(ex_runtime.what()));
+    cout << "Unable to read file: " << ex_runtime.what() << endl;
+    return;
+  }
+
+  Timer t;
+  t.Start();
+
+  const char* const data = file->GetData();
+  const char* const data_end = data + file->GetSize();
+
+  // split the file into one chunk per worker, with all chunks beginning at the start of a line
+  const std::size_t chunk_count = GetWorkerCount();
+  auto bounds = std::vector<const char*>(chunk_count + 1, data_end);
+  bounds[0] = data;
+  for (std::size_t c = 1; c < chunk_count; ++c) {
+    const char* p = std::max(bounds[c - 1], data + file->GetSize() / chunk_count * c);
+    p = std::find(p, data_end, '\n');
+    bounds[c] = p == data_end ? data_end : p + 1;
+  }
+
+  // offsets of the beginning of all matching lines, for each chunk
+  auto chunk_hits = std::vector<std::vector<std::uint64_t>>(chunk_count);
+  // message of the error which stopped matching each chunk, as exceptions cannot leave the worker threads
+  auto chunk_errors = std::vector<std::string>(chunk_count);
+  const LiteralSearcher searcher(pattern);
+  ParallelChunks(chunk_count, [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t c = begin; c < end; ++c) {
+      const char* const chunk_end = bounds[c + 1];
+      auto& hits = chunk_hits[c];
+
+      if (is_regex) {
+        const std::regex chunk_re = re;
+        for (const char* line = bounds[c]; line < chunk_end;) {
+          const char* line_end = std::find(line, chunk_end, '\n');
+          const char* next = line_end == chunk_end ? chunk_end : line_end + 1;
+
+          // remove trailing CR character in *nix systems
+          if (line_end != line && line_end[-1] == '\r') {
+            --line_end;
+          }
+
+          try {
+            if (std::regex_search(line, line_end, chunk_re)) {
+              hits.push_back(static_cast<std::uint64_t>(line - data));
+            }
+          } catch (std::regex_error& ex_regex) {
+            chunk_errors[c] = ex_regex.what();
+            break;
+          }
+          line = next;
+        }
+      } else {
+        const char* line = bounds[c];
+        for (const char* p = bounds[c]; (p = searcher.Find(p, chunk_end)) != chunk_end;) {
+          // locate the line containing the match, and skip the rest of the line
+          const char* line_begin = p;
+          while (line_begin != line && line_begin[-1] != '\n') {
+            --line_begin;
+          }
+          hits.push_back(static_cast<std::uint64_t>(line_begin - data));
+
+          const char* line_end = std::find(p, chunk_end, '\n');
+          p = line_end == chunk_end ? chunk_end : line_end + 1;
+          line = p;
+        }
+      }
+    }
+  });
+
+  for (auto&& error : chunk_errors) {
+    if (!error.empty()) {
+      LOG_E("Unable to match regular expression: " + error);
+      cout << pattern << ": Unable to match regular expression: " << error << endl;
+      return;
+    }
+  }
+
+  // map each matching line to its owning header. both lists are sorted by offset, so this is a single linear walk
+  auto packages = std::vector<const std::string*>();
+  auto package_lines = std::map<const std::string*, std::vector<std::pair<unsigned, std::uint64_t>>>();
+  std::size_t hit_count = 0;
+
+  auto header = header_locations_.cbegin();
+  std::uint64_t cursor_offset = 0;
+  unsigned cursor_line = 0;
+  for (auto&& hits : chunk_hits) {
+    for (const std::uint64_t hit : hits) {
+      while (header != header_locations_.cend() && header->offset <= hit) {
+        cursor_offset = header->offset;
+        cursor_line = header->line;
+        ++header;
+      }
+      if (header == header_locations_.cbegin()) {
+        LOG_V("Packages::Grep: Ignoring match before the first header");
+        continue;
+      }
+
+      const std::string* name = (header - 1)->name;
+      auto it = package_lines.find(name);
+      if (it == package_lines.end()) {
+        packages.emplace_back(name);
+        it = package_lines.emplace(name, std::vector<std::pair<unsigned, std::uint64_t>>()).first;
+      }
+
+      if (show_lines) {
+        cursor_line += static_cast<unsigned>(std::count(data + cursor_offset, data + hit, '\n'));
+        cursor_offset = hit;
+        it->second.emplace_back(cursor_line, hit);
+      }
+      ++hit_count;
+    }
+  }
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+
+  LOG_D("Grep complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Found " + std::to_string(hit_count) + " matching lines.");
+
+  // display all matching packages, optionally with their matching lines
+  for (auto&& p : packages) {
+    cout << *p << '\n';
+    if (show_lines) {
+      for (auto&& l : package_lines.at(p)) {
+        const char* line_begin = data + l.second;
+        const char* line_end = std::find(line_begin, data_end, '\n');
+        if (line_end != line_begin && line_end[-1] == '\r') {
+          --line_end;
+        }
+
+        std::string line(line_begin, line_end);
+        ConvertTabToSpace(line);
+        cout << "  " << l.first + 1 << ": " << line << '\n';
+      }
+    }
+  }
+  cout << endl;
+  cout << packages.size() << " entries, " << hit_count << " matching lines." << endl;
+
+  Log::FlushFileBuf();
+}
+
 /**
  * @brief Compare the contents between the loaded file and another file.
  *
  * @param cmp_filename Filename of the comparing file
  */
 void Packages::Compare(const std::string& cmp_filename) {
-  Log::i("Packages::Compare(...): " + filename_ + " <-> " + cmp_filename);
+  PROFILE_ZONE("Packages::Compare");
+  LOG_I("Packages::Compare(...): " + filename_ + " <-> " + cmp_filename);
 
-  auto cmp_filestream = std::ifstream(cmp_filename);
-  if (!cmp_filestream) {
+  auto cmp_digests = std::vector<PackageDigest>();
+  try {
+    cmp_digests = LoadPackageDigests(cmp_filename);
+    ComputeDigests();
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
     cout << cmp_filename << ": File not found." << endl;
     return;
   }
-  auto cmp_file = std::make_unique<Packages>(cmp_filename, std::move(cmp_filestream));
 
   auto has_current = std::vector<std::string>();
   auto has_compare = std::vector<std::string>();
+  auto has_modified = std::vector<std::string>();
 
-  const std::map<std::string, unsigned>& cmp_file_headers = cmp_file->headers_;
-
-  Log::d("Begin header comparison");
+  LOG_D("Begin header comparison");
 
   Timer t;
   t.Start();
 
-  cout << "Searching for new keys in current file..." << endl;
-  for (auto&& h : headers_) {
-    if (cmp_file_headers.find(h.first) == cmp_file_headers.cend()) {
-      has_current.emplace_back(h.first);
-    }
-  }
-
-  cout << "Searching for new keys in comparing file..." << endl;
-  for (auto&& h : cmp_file_headers) {
-    if (headers_.find(h.first) == headers_.cend()) {
-      has_compare.emplace_back(h.first);
+  // both header lists are sorted, so they can be compared by a single merge pass
+  cout << "Comparing headers and contents..." << endl;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < header_names_.size() || j < cmp_digests.size()) {
+    if (j == cmp_digests.size() || (i < header_names_.size() && *header_names_[i] < cmp_digests[j].name)) {
+      has_current.emplace_back(*header_names_[i++]);
+    } else if (i == header_names_.size() || cmp_digests[j].name < *header_names_[i]) {
+      has_compare.emplace_back(std::move(cmp_digests[j++].name));
+    } else {
+      if (header_hashes_[i] != cmp_digests[j].hash) {
+        has_modified.emplace_back(*header_names_[i]);
+      }
+      ++i;
+      ++j;
     }
   }
 
   t.Stop();
   auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
 
-  Log::d("Comparison complete. Took " + std::to_string(time) + "ms.");
+  LOG_D("Comparison complete. Took " + std::to_string(time) + "ms.");
 
   ClearScreen();
 
@@ -192,75 +523,614 @@ void Packages::Compare(const std::string& cmp_filename) {
     cout << endl;
   }
 
-  if (!has_current.empty() || !has_compare.empty()) {
-    cout << has_current.size() << " additions, " << has_compare.size() << " deletions" << endl;
+  if (!has_modified.empty()) {
+    cout << "Headers whose contents differ between versions: " << endl;
+    for (auto&& h : has_modified) {
+      cout << h << '\n';
+    }
+    cout << endl;
+  }
+
+  if (!has_current.empty() || !has_compare.empty() || !has_modified.empty()) {
+    cout << has_current.size() << " additions, " << has_compare.size() << " deletions, " << has_modified.size()
+         << " modifications" << endl;
   } else {
-    cout << "Headers are identical." << endl;
+    cout << "Headers and contents are identical." << endl;
   }
 
   Log::FlushFileBuf();
 }
 
 /**
- * @brief Lookup the header based on the line number.
+ * @brief Compare the headers and contents across many files at once.
  *
- * @param line Line number to lookup
- * @param is_interactive If true, will prompt user if they want to view the header contents
+ * @param filenames Filenames of all files, from oldest to newest
+ * @param show_all Whether to also show headers which exist unchanged in all files
  */
-void Packages::ReverseLookup(unsigned line, bool is_interactive) {
-  auto rev_headers = std::map<unsigned, std::string>();
+void Packages::CompareMany(const std::vector<std::string>& filenames, bool show_all) {
+  PROFILE_ZONE("Packages::CompareMany");
+  LOG_I("Packages::CompareMany(" + JoinToString(filenames, " ") + ")");
+
+  const std::size_t file_count = filenames.size();
+  auto digests = std::vector<std::vector<PackageDigest>>(file_count);
+  auto errors = std::vector<std::string>(file_count);
+
+  Timer t;
+  t.Start();
+
+  // index every distinct file on its own thread, as files listed more than once share the same sidecar file
+  cout << "Indexing " << file_count << " files..." << endl;
+  auto threads = std::vector<std::thread>();
+  threads.reserve(file_count);
+  for (std::size_t f = 0; f < file_count; ++f) {
+    if (std::find(filenames.begin(), filenames.begin() + static_cast<std::ptrdiff_t>(f), filenames[f]) !=
+        filenames.begin() + static_cast<std::ptrdiff_t>(f)) {
+      continue;
+    }
+
+    threads.emplace_back([&, f] {
+      try {
+        digests[f] = LoadPackageDigests(filenames[f]);
+      } catch (std::runtime_error& ex_runtime) {
+        errors[f] = ex_runtime.what();
+      }
+    });
+  }
+  for (auto&& th : threads) {
+    th.join();
+  }
+  for (std::size_t f = 0; f < file_count; ++f) {
+    auto first = std::find(filenames.begin(), filenames.end(), filenames[f]);
+    if (first != filenames.begin() + static_cast<std::ptrdiff_t>(f)) {
+      digests[f] = digests[static_cast<std::size_t>(first - filenames.begin())];
+    }
+  }
+
+  for (std::size_t f = 0; f < file_count; ++f) {
+    if (!errors[f].empty()) {
+      LOG_E(filenames[f] + ": " + errors[f]);
+      cout << filenames[f] << ": File not found." << endl;
+      return;
+    }
+  }
+
+  // k-way merge over the sorted digest lists, visiting each header once in sorted order
+  using Cursor = std::pair<const std::string*, std::size_t>;
+  auto cursor_greater = [](const Cursor& a, const Cursor& b) {
+    return *a.first != *b.first ? *a.first > *b.first : a.second > b.second;
+  };
+  auto heap = std::priority_queue<Cursor, std::vector<Cursor>, decltype(cursor_greater)>(cursor_greater);
+  auto positions = std::vector<std::size_t>(file_count, 0);
+  for (std::size_t f = 0; f < file_count; ++f) {
+    if (!digests[f].empty()) {
+      heap.emplace(&digests[f].front().name, f);
+    }
+  }
+
+  std::ostringstream rows;
+  std::size_t header_count = 0;
+  std::size_t stable_count = 0;
+  auto present = std::vector<const PackageDigest*>(file_count);
+  while (!heap.empty()) {
+    const std::string name = *heap.top().first;
+    std::fill(present.begin(), present.end(), nullptr);
+
+    // cursors with the same name are popped in file order
+    while (!heap.empty() && *heap.top().first == name) {
+      const std::size_t f = heap.top().second;
+      heap.pop();
+
+      present[f] = &digests[f][positions[f]++];
+      if (positions[f] < digests[f].size()) {
+        heap.emplace(&digests[f][positions[f]].name, f);
+      }
+    }
+    ++header_count;
+
+    std::size_t first_seen = file_count;
+    std::size_t last_seen = 0;
+    for (std::size_t f = 0; f < file_count; ++f) {
+      if (present[f] != nullptr) {
+        first_seen = std::min(first_seen, f);
+        last_seen = f;
+      }
+    }
 
-  Log::d("Reversing header map...");
+    // a header changes in a file if it is removed, added back or modified since the file before it
+    auto changed_in = std::vector<std::string>();
+    for (std::size_t f = first_seen + 1; f <= last_seen; ++f) {
+      const PackageDigest* prev = present[f - 1];
+      if ((prev == nullptr) != (present[f] == nullptr) || (prev != nullptr && prev->hash != present[f]->hash)) {
+        changed_in.emplace_back(std::to_string(f));
+      }
+    }
+
+    const bool is_stable = changed_in.empty() && std::find(present.begin(), present.end(), nullptr) == present.end();
+    if (is_stable) {
+      ++stable_count;
+      if (!show_all) {
+        continue;
+      }
+    }
+
+    std::string changed = JoinToString(changed_in, ",");
+    if (!changed.empty()) {
+      changed.pop_back();
+    }
+    rows << name << '\t' << first_seen << '\t' << last_seen << '\t' << (changed.empty() ? "-" : changed) << '\n';
+  }
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  LOG_D("Comparison complete. Took " + std::to_string(time) + "ms.");
+
+  ClearScreen();
+
+  for (std::size_t f = 0; f < file_count; ++f) {
+    cout << "[" << f << "] " << filenames[f] << '\n';
+  }
+  cout << '\n';
+  cout << "Header\tFirst Seen\tLast Seen\tChanged In" << '\n';
+  cout << rows.str();
+  cout << endl;
+  cout << header_count << " headers, " << header_count - stable_count << " not identical across all files." << endl;
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Compare the fields of a header between the loaded file and another file.
+ *
+ * @param header Header to compare
+ * @param cmp_filename Filename of the comparing file
+ * @param as_json Whether to output the differences as a JSON Patch
+ */
+void Packages::Diff(const std::string& header, const std::string& cmp_filename, bool as_json) {
+  PROFILE_ZONE("Packages::Diff");
+  LOG_I("Packages::Diff(" + header + "): " + filename_ + " <-> " + cmp_filename);
+
+  auto search = headers_.find(header);
+  if (search == headers_.end()) {
+    cout << "Cannot find header." << endl;
+    return;
+  }
+
+  auto cmp_digests = std::vector<PackageDigest>();
+  std::unique_ptr<MappedFile> file;
+  std::unique_ptr<MappedFile> cmp_file;
+  try {
+    cmp_digests = LoadPackageDigests(cmp_filename);
+    file = std::make_unique<MappedFile>(filename_);
+    cmp_file = std::make_unique<MappedFile>(cmp_filename);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
+    cout << cmp_filename << ": File not found." << endl;
+    return;
+  }
+
+  auto cmp_it = std::lower_bound(cmp_digests.begin(), cmp_digests.end(), header,
+                                 [](const PackageDigest& d, const std::string& h) { return d.name < h; });
+  if (cmp_it == cmp_digests.end() || cmp_it->name != header) {
+    cout << cmp_filename << ": Cannot find header." << endl;
+    return;
+  }
+
+  // the comparing file is the old version, consistent with Compare
+  const auto from = FlattenPackageBody(ReadPackageBody(*cmp_file, cmp_it->offset));
+  const auto to = FlattenPackageBody(ReadPackageBody(*file, GetHeaderAtLine(search->second)->offset));
+  const auto changes = DiffPackageFields(from, to);
+
+  if (as_json) {
+    const std::string patch = FormatJsonPatch(changes, from, to, "");
+    cout << "[" << (patch.empty() ? "" : "\n" + patch + "\n") << "]" << endl;
+  } else if (changes.empty()) {
+    cout << "Fields are identical." << endl;
+  } else {
+    cout << FormatFieldChanges(changes, from, to) << endl;
+    cout << changes.size() << " field changes." << endl;
+  }
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Compare the fields of all modified headers between the loaded file and another file.
+ *
+ * @param cmp_filename Filename of the comparing file
+ * @param as_json Whether to output the differences as a JSON Patch
+ */
+void Packages::DiffAll(const std::string& cmp_filename, bool as_json) {
+  PROFILE_ZONE("Packages::DiffAll");
+  LOG_I("Packages::DiffAll(...): " + filename_ + " <-> " + cmp_filename);
+
+  auto cmp_digests = std::vector<PackageDigest>();
+  std::unique_ptr<MappedFile> file;
+  std::unique_ptr<MappedFile> cmp_file;
+  try {
+    cmp_digests = LoadPackageDigests(cmp_filename);
+    ComputeDigests();
+    file = std::make_unique<MappedFile>(filename_);
+    cmp_file = std::make_unique<MappedFile>(cmp_filename);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
+    cout << cmp_filename << ": File not found." << endl;
+    return;
+  }
 
   Timer t;
   t.Start();
 
-  cout << "Loading..." << endl;
+  // only headers whose digests differ need to be compared field by field
+  auto modified = std::vector<std::pair<std::size_t, std::size_t>>();
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < header_names_.size() && j < cmp_digests.size()) {
+    if (*header_names_[i] < cmp_digests[j].name) {
+      ++i;
+    } else if (cmp_digests[j].name < *header_names_[i]) {
+      ++j;
+    } else {
+      if (header_hashes_[i] != cmp_digests[j].hash) {
+        modified.emplace_back(i, j);
+      }
+      ++i;
+      ++j;
+    }
+  }
+
+  auto outputs = std::vector<std::string>(modified.size());
+  auto change_counts = std::vector<std::size_t>(modified.size());
+  ParallelChunks(modified.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t k = begin; k < end; ++k) {
+      const std::string& name = *header_names_[modified[k].first];
+      const HeaderLocation* location = GetHeaderAtLine(headers_.find(name)->second);
 
-  std::for_each(headers_.begin(), headers_.end(), [&rev_headers](const std::pair<std::string, unsigned>& a) {
-    rev_headers.emplace(a.second, a.first);
+      const auto from = FlattenPackageBody(ReadPackageBody(*cmp_file, cmp_digests[modified[k].second].offset));
+      const auto to = FlattenPackageBody(ReadPackageBody(*file, location->offset));
+      const auto changes = DiffPackageFields(from, to);
+
+      change_counts[k] = changes.size();
+      outputs[k] = as_json ? FormatJsonPatch(changes, from, to, name) : FormatFieldChanges(changes, from, to);
+    }
   });
 
   t.Stop();
   auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  LOG_D("Field comparison complete. Took " + std::to_string(time) + "ms.");
+
+  std::size_t change_count = 0;
+  if (as_json) {
+    bool is_first = true;
+    cout << "[";
+    for (auto&& o : outputs) {
+      if (o.empty()) {
+        continue;
+      }
+      cout << (is_first ? "\n" : ",\n") << o;
+      is_first = false;
+    }
+    cout << (is_first ? "" : "\n") << "]" << endl;
+  } else {
+    for (std::size_t k = 0; k < modified.size(); ++k) {
+      change_count += change_counts[k];
+      cout << *header_names_[modified[k].first] << '\n';
+      std::string::size_type pos = 0;
+      for (std::string::size_type next; (next = outputs[k].find('\n', pos)) != std::string::npos; pos = next + 1) {
+        cout << "  " << outputs[k].substr(pos, next - pos) << '\n';
+      }
+    }
+    cout << endl;
+    cout << modified.size() << " modified packages, " << change_count << " field changes." << endl;
+  }
 
-  Log::d("Reversal complete. Took " + std::to_string(time) + "ms.");
+  Log::FlushFileBuf();
+}
 
-  t.Reset();
+/**
+ * @brief Output a unified diff between another file and the loaded file, with hunks grouped by header.
+ *
+ * @param cmp_filename Filename of the comparing file, which is treated as the old version
+ * @param outfile Filename to write the diff to, or "-" for standard output
+ * @param context Number of unchanged lines to show around each change
+ */
+void Packages::UnifiedDiff(const std::string& cmp_filename, const std::string& outfile, unsigned context) {
+  PROFILE_ZONE("Packages::UnifiedDiff");
+  LOG_I("Packages::UnifiedDiff(...): " + cmp_filename + " -> " + filename_);
 
-  Log::d("Searching for line...");
+  auto cmp_digests = std::vector<PackageDigest>();
+  std::unique_ptr<MappedFile> file;
+  std::unique_ptr<MappedFile> cmp_file;
+  try {
+    cmp_digests = LoadPackageDigests(cmp_filename);
+    ComputeDigests();
+    file = std::make_unique<MappedFile>(filename_);
+    cmp_file = std::make_unique<MappedFile>(cmp_filename);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_E(ex_runtime.what());
+    cout << cmp_filename << ": File not found." << endl;
+    return;
+  }
 
+  Timer t;
   t.Start();
 
-  auto i = rev_headers.end();
-  for (auto it = rev_headers.begin(); it != rev_headers.end(); ++it) {
-    if (it->first + 1 > line) {
-      i = --it;
-      break;
+  // pair headers by name; an index past the end of either list marks a header which only exists on one side
+  constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+  auto pairs = std::vector<std::pair<std::size_t, std::size_t>>();
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < header_names_.size() || j < cmp_digests.size()) {
+    if (j == cmp_digests.size() || (i < header_names_.size() && *header_names_[i] < cmp_digests[j].name)) {
+      pairs.emplace_back(i++, kNone);
+    } else if (i == header_names_.size() || cmp_digests[j].name < *header_names_[i]) {
+      pairs.emplace_back(kNone, j++);
+    } else {
+      if (header_hashes_[i] != cmp_digests[j].hash) {
+        pairs.emplace_back(i, j);
+      }
+      ++i;
+      ++j;
+    }
+  }
+
+  const char* const cmp_data = cmp_file->GetData();
+  const char* const cmp_data_end = cmp_data + cmp_file->GetSize();
+  auto find_cmp = [&](const std::string& name) {
+    auto it = std::lower_bound(cmp_digests.cbegin(), cmp_digests.cend(), name,
+                               [](const PackageDigest& d, const std::string& n) { return d.name < n; });
+    return it != cmp_digests.cend() && it->name == name ? static_cast<std::size_t>(it - cmp_digests.cbegin()) : kNone;
+  };
+  auto find_id = [&](const std::string& name) {
+    auto it = std::lower_bound(header_names_.cbegin(), header_names_.cend(), name,
+                               [](const std::string* h, const std::string& n) { return *h < n; });
+    return it != header_names_.cend() && **it == name ? static_cast<std::size_t>(it - header_names_.cbegin()) : kNone;
+  };
+
+  // headers which only exist on one side are anchored to the line before their position in the other file, as in
+  // diff(1). added headers are placed just before the next header which exists in both files, and removed headers
+  // just after the previous one, so that removals come before additions at the same position
+  auto anchors = std::vector<unsigned>(pairs.size(), 0);
+  {
+    auto pair_of_id = std::vector<std::size_t>(header_names_.size(), kNone);
+    auto pair_of_cmp_id = std::vector<std::size_t>(cmp_digests.size(), kNone);
+    for (std::size_t k = 0; k < pairs.size(); ++k) {
+      if (pairs[k].second == kNone) {
+        pair_of_id[pairs[k].first] = k;
+      } else if (pairs[k].first == kNone) {
+        pair_of_cmp_id[pairs[k].second] = k;
+      }
+    }
+
+    unsigned cmp_line_count = 0;
+    auto cmp_order = std::vector<std::size_t>();
+    for (std::size_t cmp_id = 0; cmp_id < cmp_digests.size(); ++cmp_id) {
+      cmp_order.push_back(cmp_id);
+    }
+    std::sort(cmp_order.begin(), cmp_order.end(),
+              [&](std::size_t x, std::size_t y) { return cmp_digests[x].line < cmp_digests[y].line; });
+    if (cmp_order.empty()) {
+      cmp_line_count = static_cast<unsigned>(std::count(cmp_data, cmp_data_end, '\n'));
+    } else {
+      const PackageDigest& last = cmp_digests[cmp_order.back()];
+      cmp_line_count = last.line + static_cast<unsigned>(std::count(cmp_data + last.offset, cmp_data_end, '\n'));
+    }
+    if (cmp_data != cmp_data_end && cmp_data_end[-1] != '\n') {
+      ++cmp_line_count;
+    }
+
+    // later definitions of a header are not diffed, and are treated as part of the previous header
+    unsigned next_common_line = cmp_line_count;
+    for (auto it = header_locations_.crbegin(); it != header_locations_.crend(); ++it) {
+      if (headers_.find(*it->name)->second != it->line) {
+        continue;
+      }
+      const std::size_t cmp_id = find_cmp(*it->name);
+      if (cmp_id != kNone) {
+        next_common_line = cmp_digests[cmp_id].line;
+      } else {
+        anchors[pair_of_id[find_id(*it->name)]] = next_common_line;
+      }
+    }
+
+    unsigned prev_common_end = header_locations_.empty() ? line_count_ : header_locations_.front().line;
+    for (auto&& cmp_id : cmp_order) {
+      const auto header = headers_.find(cmp_digests[cmp_id].name);
+      if (header == headers_.cend()) {
+        anchors[pair_of_cmp_id[cmp_id]] = prev_common_end;
+        continue;
+      }
+      const HeaderLocation* location = GetHeaderAtLine(header->second);
+      prev_common_end = location + 1 == header_locations_.data() + header_locations_.size() ? line_count_
+                                                                                             : (location + 1)->line;
     }
   }
 
+  // headers which only exist on one side are diffed against an empty body, including their header lines. lines keep
+  // their CR characters, so that the diff applies to files with CRLF line endings
+  auto hunks = std::vector<std::string>(pairs.size());
+  ParallelChunks(pairs.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+    for (std::size_t k = begin; k < end; ++k) {
+      const std::size_t id = pairs[k].first;
+      const std::size_t cmp_id = pairs[k].second;
+
+      auto a = std::vector<std::string>();
+      auto b = std::vector<std::string>();
+      unsigned a_first_line = anchors[k] + 1;
+      unsigned b_first_line = anchors[k] + 1;
+      const bool inc_header = id == kNone || cmp_id == kNone;
+      if (cmp_id != kNone) {
+        a = ReadPackageBody(*cmp_file, cmp_digests[cmp_id].offset, inc_header, true);
+        a_first_line = cmp_digests[cmp_id].line + (inc_header ? 1 : 2);
+      }
+      if (id != kNone) {
+        const HeaderLocation* location = GetHeaderAtLine(headers_.find(*header_names_[id])->second);
+        b = ReadPackageBody(*file, location->offset, inc_header, true);
+        b_first_line = location->line + (inc_header ? 1 : 2);
+      }
+
+      const std::string& name = id != kNone ? *header_names_[id] : cmp_digests[cmp_id].name;
+      hunks[k] = FormatUnifiedHunks(a, b, MyersDiff(HashLines(a), HashLines(b)), a_first_line, b_first_line,
+                                    context, name);
+    }
+  });
+
   t.Stop();
-  time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+  LOG_D("Unified diff complete. Took " + std::to_string(time) + "ms.");
 
-  Log::d("Search complete. Took " + std::to_string(time) + "ms.");
+  std::ofstream ofs;
+  if (outfile != "-") {
+    ofs.open(outfile, std::ios::binary);
+    if (!ofs) {
+      cout << outfile << ": Cannot open file for writing." << endl;
+      return;
+    }
+  }
+  std::ostream& os = outfile != "-" ? ofs : cout;
+
+  // hunks are written in the order of the old file, so that the diff can be applied with patch(1)
+  auto order = std::vector<std::tuple<unsigned, bool, unsigned, std::size_t>>();
+  for (std::size_t k = 0; k < pairs.size(); ++k) {
+    const std::size_t id = pairs[k].first;
+    const std::size_t cmp_id = pairs[k].second;
+    const unsigned line = id == kNone ? anchors[k] : headers_.find(*header_names_[id])->second;
+    const unsigned cmp_line = cmp_id == kNone ? anchors[k] : cmp_digests[cmp_id].line;
+    order.emplace_back(cmp_line, cmp_id != kNone, line, k);
+  }
+  std::sort(order.begin(), order.end());
+
+  os << "--- " << cmp_filename << '\n';
+  os << "+++ " << filename_ << '\n';
+  for (auto&& o : order) {
+    os << hunks[std::get<3>(o)];
+  }
+  os.flush();
+
+  if (outfile != "-") {
+    cout << pairs.size() << " packages differ. Diff written to " << outfile << "." << endl;
+  }
+
+  Log::FlushFileBuf();
+}
+
+/**
+ * @brief Lookup the header based on the line number.
+ *
+ * @param line Line number to lookup
+ * @param is_interactive If true, will prompt user if they want to view the header contents
+ */
+void Packages::ReverseLookup(unsigned line, bool is_interactive) {
+  PROFILE_ZONE("Packages::ReverseLookup");
+  LOG_D("Searching for line...");
+
+  Timer t;
+  t.Start();
+
+  const HeaderLocation* header = line == 0 ? nullptr : GetHeaderAtLine(line - 1);
+
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::microseconds>(t.GetRawTime()).count());
+
+  LOG_D("Search complete. Took " + std::to_string(time) + "us.");
 
   ClearScreen();
 
-  if (i != rev_headers.end()) {
-    cout << "Entry at line " << line << ": " << i->second << endl;
-    cout << "Entry begins at line " << i->first + 1 << endl << endl;
+  if (header != nullptr) {
+    cout << "Entry at line " << line << ": " << *header->name << endl;
+    cout << "Entry begins at line " << header->line + 1 << endl << endl;
     if (is_interactive) {
       cout << "View Package Details? [y/N] ";
       std::string resp;
       getline(cin, resp);
       if (resp == "y" || resp == "Y") {
-        OutputHeader(i->second, false);
+        OutputHeader(*header->name, false);
       }
     }
   } else {
-    Log::w("Line " + std::to_string(line) + " has no entry");
+    LOG_W("Line " + std::to_string(line) + " has no entry");
     cout << "No entry found at line " << line << endl << endl;
   }
+}
+
+/**
+ * @brief Lookup the headers of many line numbers at once.
+ *
+ * Line numbers are resolved in a single pass over the header locations, and are output in the order they are read.
+ * Reading stops at the end of the stream, or at a line containing only '.', so that the rest of a shared stream such as
+ * standard input is left to the caller.
+ *
+ * @param is Input stream of whitespace-separated line numbers
+ */
+void Packages::ReverseLookupBatch(std::istream& is) {
+  PROFILE_ZONE("Packages::ReverseLookupBatch");
+  auto lines = std::vector<std::pair<unsigned, std::size_t>>();
+  std::size_t skipped = 0;
+
+  std::string input_line;
+  std::string token;
+  while (getline(is, input_line)) {
+    auto tokens = std::istringstream(input_line);
+    if (tokens >> token && token == "." && !(tokens >> token)) {
+      break;
+    }
+
+    tokens.clear();
+    tokens.seekg(0);
+    while (tokens >> token) {
+      try {
+        lines.emplace_back(static_cast<unsigned>(std::stoul(token)), lines.size());
+      } catch (std::logic_error& ex_logic) {
+        ++skipped;
+      }
+    }
+  }
+
+  LOG_D("Resolving " + std::to_string(lines.size()) + " lines...");
+
+  Timer t;
+  t.Start();
+
+  // walk the sorted line numbers and the sorted header locations together
+  auto results = std::vector<const HeaderLocation*>(lines.size(), nullptr);
+  std::sort(lines.begin(), lines.end());
+
+  auto header = header_locations_.cbegin();
+  for (auto&& l : lines) {
+    if (l.first == 0 || l.first > line_count_) {
+      continue;
+    }
+
+    while (header != header_locations_.cend() && header->line <= l.first - 1) {
+      ++header;
+    }
+    if (header != header_locations_.cbegin()) {
+      results[l.second] = &*(header - 1);
+    }
+  }
 
+  t.Stop();
+  auto time = static_cast<unsigned>(std::chrono::duration_cast<Timer::milliseconds>(t.GetRawTime()).count());
+
+  LOG_D("Resolution complete. Took " + std::to_string(time) + "ms.");
+  if (skipped != 0) {
+    LOG_W("Skipped " + std::to_string(skipped) + " tokens which are not line numbers");
+  }
+
+  // restore the input order for output
+  std::sort(lines.begin(), lines.end(),
+            [](const std::pair<unsigned, std::size_t>& a, const std::pair<unsigned, std::size_t>& b) {
+              return a.second < b.second;
+            });
+  for (auto&& l : lines) {
+    const HeaderLocation* h = results[l.second];
+    if (h != nullptr) {
+      cout << l.first << '\t' << *h->name << '\t' << h->line + 1 << '\n';
+    } else {
+      cout << l.first << '\t' << "(none)" << '\n';
+    }
+  }
+  cout << endl;
+  cout << lines.size() << " lines resolved." << endl;
+
+  Log::FlushFileBuf();
 }
@@ -0,0 +1,109 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for PerfCounters class.
+//
+
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#if defined(__linux__)
+namespace {
+/**
+ * @brief Hardware event of each counter, indexed by @c PerfCounters::Event.
+ */
+constexpr std::array<std::uint64_t, PerfCounters::kEventCount> kHardwareEvents = {{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+}};
+
+/**
+ * @brief Opens a counter of the calling thread.
+ *
+ * @param config Hardware event to count
+ * @param group_fd File descriptor of the group leader, or -1 to open a new group
+ * @return File descriptor of the counter, or -1 if it cannot be opened
+ */
+auto OpenCounter(std::uint64_t config, int group_fd) -> int {
+  perf_event_attr attr{};
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+}  // namespace
+#endif  // defined(__linux__)
+
+PerfCounters::PerfCounters() {
+  fds_.fill(-1);
+
+#if defined(__linux__)
+  // all counters are opened as one group, so that they are scheduled onto the PMU together
+  for (std::size_t i = 0; i < kEventCount; ++i) {
+    fds_[i] = OpenCounter(kHardwareEvents[i], fds_[0]);
+    if (fds_[i] == -1) {
+      const std::string error = std::strerror(errno);
+      for (std::size_t j = 0; j < i; ++j) {
+        close(fds_[j]);
+      }
+      throw std::runtime_error("Cannot open hardware performance counters: " + error);
+    }
+  }
+
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+  throw std::runtime_error("Hardware performance counters are not supported on this platform");
+#endif  // defined(__linux__)
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+  for (auto fd : fds_) {
+    close(fd);
+  }
+#endif  // defined(__linux__)
+}
+
+auto PerfCounters::Read(Values* const values) const -> bool {
+#if defined(__linux__)
+  // layout of a group read: number of counters, time enabled, time running, then the value of each counter
+  std::array<std::uint64_t, 3 + kEventCount> buffer{};
+  if (read(fds_[0], buffer.data(), sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)) ||
+      buffer[0] != kEventCount) {
+    return false;
+  }
+
+  // scale the values up if the group has been multiplexed with other events
+  const std::uint64_t enabled = buffer[1];
+  const std::uint64_t running = buffer[2];
+  for (std::size_t i = 0; i < kEventCount; ++i) {
+    (*values)[i] = running == 0 || running == enabled
+                       ? buffer[3 + i]
+                       : static_cast<std::uint64_t>(static_cast<double>(buffer[3 + i]) *
+                                                    static_cast<double>(enabled) / static_cast<double>(running));
+  }
+  return true;
+#else
+  static_cast<void>(values);
+  return false;
+#endif  // defined(__linux__)
+}
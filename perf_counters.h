@@ -0,0 +1,51 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for reading hardware performance counters.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_PERF_COUNTERS_H_
+#define WARFRAME_PACKAGES_DEPARSER_PERF_COUNTERS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Group of hardware performance counters of the calling thread.
+ *
+ * On Linux the counters are opened with @c perf_event_open, and only count events of the thread which constructed
+ * them. On other systems the counters are never available.
+ */
+class PerfCounters {
+ public:
+  enum Event : std::size_t { kCycles, kInstructions, kCacheMisses, kBranchMisses, kEventCount };
+
+  using Values = std::array<std::uint64_t, kEventCount>;
+
+  /**
+   * Constructor. Opens and starts all counters for the calling thread.
+   *
+   * @throw @c std::runtime_error if the counters are not available, e.g. if the kernel denies access
+   */
+  PerfCounters();
+  PerfCounters(PerfCounters&&) = delete;
+  PerfCounters(const PerfCounters&) = delete;
+  auto operator=(PerfCounters&&) noexcept -> PerfCounters& = delete;
+  auto operator=(const PerfCounters&) -> PerfCounters& = delete;
+  ~PerfCounters();
+
+  /**
+   * Reads the current values of all counters.
+   *
+   * @param values Values of all counters, indexed by @c Event
+   * @return True if successful
+   */
+  auto Read(Values* values) const -> bool;
+
+ private:
+  std::array<int, kEventCount> fds_{};
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_PERF_COUNTERS_H_
@@ -6,8 +6,23 @@
 
 #include "prettify.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "config_file.h"
+#include "hash.h"
 #include "log.h"
+#include "profiler.h"
 
 /**
  * @brief Class for custom comparator.
@@ -31,21 +46,14 @@ struct StrCompare {
 };
 
 /**
- * @brief Replacement pairs for normal variables.
- */
-std::map<std::string, std::string, StrCompare> NormVarReplaceSet;
-/**
- * @brief Replacement pairs for boolean variables.
- */
-std::map<std::string, std::string, StrCompare> BoolVarReplaceSet;
-/**
- * @brief Replacement pairs for path variables (/...)
+ * @brief Ordered set of replacement pairs.
  */
-std::map<std::string, std::string, StrCompare> LotusVarReplaceSet;
+using ReplaceSet = std::map<std::string, std::string, StrCompare>;
+
 /**
  * @brief Replacement pairs for syntactical constants.
  */
-const std::map<std::string, std::string, StrCompare> kSyntaxReplaceSet = {
+const ReplaceSet kSyntaxReplaceSet = {
     {"=", ": "},
     {"{}", "(empty hash)"},
     {"[]", "(empty array)"},
@@ -54,111 +62,402 @@ const std::map<std::string, std::string, StrCompare> kSyntaxReplaceSet = {
 /**
  * @brief Replacement pairs for boolean constants.
  */
-const std::map<std::string, std::string, StrCompare> kBoolReplaceSet = {
+const ReplaceSet kBoolReplaceSet = {
     {"0", "false"},
     {"1", "true"}
 };
 
+namespace {
 /**
- * @brief Parse prettify file.
- *
- * This function will attempt to read, and if successful, parse and store the prettify pairs from the file.
+ * @brief Marker for a missing state in the automaton.
+ */
+constexpr std::uint32_t kNoState = static_cast<std::uint32_t>(-1);
+
+/**
+ * @brief A single replacement pair, in the order it is applied.
+ */
+struct Replacement {
+  std::string pattern;
+  std::string replacement;
+  /**
+   * @brief Whether the first boolean constant is also replaced after the pattern is replaced.
+   */
+  bool is_bool;
+};
+}  // namespace
+
+/**
+ * Aho-Corasick automaton over all replacement patterns.
  *
- * @param filename Filename of the prettify file
+ * Replacements are applied with the same semantics as applying each replacement set in turn: every pattern is
+ * visited once in order, and its first occurrence in the line at that point is replaced. A single pass of the
+ * automaton finds which patterns occur in the line, so that only patterns which occur are visited. As a
+ * replacement may create or destroy occurrences of later patterns, the text around every replacement is scanned again.
  */
-void ParsePrettify(const std::string& filename) {
-  ConfigFile cf(filename);
-  if (cf.ReadFromFile()) {
-    Log::d("Prettify file is valid");
-
-    // [normal]
-    try {
-      const std::map<std::string, std::string>& norm_replace = cf.GetSection("normal");
-      NormVarReplaceSet.clear();
-      for (auto&& set : norm_replace) {
-        NormVarReplaceSet.emplace(set.first, set.second);
-      }
-    } catch (std::runtime_error& rt_ex) {
-      Log::w("Section \"normal\" not found. Will not replace normal fields");
+class ReplacementAutomaton {
+ public:
+  explicit ReplacementAutomaton(std::vector<Replacement> replacements);
 
-      // no need to handle it
-    }
+  void Apply(std::string& s) const;
+
+ private:
+  void Rescan(const std::string& s, std::size_t pos, std::size_t length, std::size_t first,
+              std::vector<char>* present) const;
+  void Scan(const std::string& s, std::size_t begin, std::size_t end, std::size_t first,
+            std::vector<char>* present) const;
+
+  std::vector<Replacement> replacements_;
+  /**
+   * @brief Indices of replacements with an empty pattern, which occur in every line.
+   */
+  std::vector<std::size_t> empty_patterns_;
+  /**
+   * @brief Length of the longest pattern.
+   */
+  std::size_t max_pattern_length_ = 0;
+
+  /**
+   * @brief Equivalence class of each byte. Bytes which do not appear in any pattern share class 0.
+   */
+  std::array<std::uint32_t, 256> byte_classes_{};
+  std::uint32_t class_count_ = 1;
+  /**
+   * @brief Transition table of the automaton, indexed by state and byte class.
+   */
+  std::vector<std::uint32_t> transitions_;
+  /**
+   * @brief Indices of the replacements whose pattern ends at each state.
+   */
+  std::vector<std::vector<std::size_t>> terminals_;
+  /**
+   * @brief Nearest state along the failure chain of each state which has terminals, or @c kNoState.
+   */
+  std::vector<std::uint32_t> output_links_;
+};
 
-    // [bool]
-    try {
-      const std::map<std::string, std::string>& bool_replace = cf.GetSection("bool");
-      BoolVarReplaceSet.clear();
-      for (auto&& set : bool_replace) {
-        BoolVarReplaceSet.emplace(set.first, set.second);
+ReplacementAutomaton::ReplacementAutomaton(std::vector<Replacement> replacements)
+    : replacements_(std::move(replacements)) {
+  for (auto&& r : replacements_) {
+    max_pattern_length_ = std::max(max_pattern_length_, r.pattern.size());
+    for (char c : r.pattern) {
+      auto& cls = byte_classes_[static_cast<unsigned char>(c)];
+      if (cls == 0) {
+        cls = class_count_++;
       }
-    } catch (std::runtime_error& rt_ex) {
-      Log::w("Section \"bool\" not found. Will not replace boolean fields");
+    }
+  }
 
-      // no need to handle it
+  // build the trie of all patterns
+  transitions_.assign(class_count_, kNoState);
+  terminals_.emplace_back();
+  for (std::size_t i = 0; i < replacements_.size(); ++i) {
+    if (replacements_[i].pattern.empty()) {
+      empty_patterns_.push_back(i);
+      continue;
     }
 
-    // [lotus]
-    try {
-      const std::map<std::string, std::string>& lotus_replace = cf.GetSection("lotus");
-      LotusVarReplaceSet.clear();
-      for (auto&& set : lotus_replace) {
-        LotusVarReplaceSet.emplace(set.first, set.second);
+    std::uint32_t state = 0;
+    for (char c : replacements_[i].pattern) {
+      std::uint32_t& next = transitions_[state * class_count_ + byte_classes_[static_cast<unsigned char>(c)]];
+      if (next == kNoState) {
+        next = static_cast<std::uint32_t>(terminals_.size());
+        terminals_.emplace_back();
+        transitions_.resize(transitions_.size() + class_count_, kNoState);
       }
-    } catch (std::runtime_error& rt_ex) {
-      Log::w("Section \"lotus\" not found. Will not replace item fields");
+      state = transitions_[state * class_count_ + byte_classes_[static_cast<unsigned char>(c)]];
+    }
+    terminals_[state].push_back(i);
+  }
 
-      // no need to handle it
+  // compute failure links in breadth-first order, and complete the transition table into a DFA
+  const auto state_count = static_cast<std::uint32_t>(terminals_.size());
+  auto failure = std::vector<std::uint32_t>(state_count, 0);
+  output_links_.assign(state_count, kNoState);
+  auto queue = std::deque<std::uint32_t>();
+  for (std::uint32_t cls = 0; cls < class_count_; ++cls) {
+    std::uint32_t& next = transitions_[cls];
+    if (next == kNoState) {
+      next = 0;
+    } else {
+      queue.push_back(next);
     }
+  }
+  while (!queue.empty()) {
+    const std::uint32_t state = queue.front();
+    queue.pop_front();
 
-  } else {
-    Log::d("Prettify file is invalid. Will not replace fields.");
+    for (std::uint32_t cls = 0; cls < class_count_; ++cls) {
+      std::uint32_t& next = transitions_[state * class_count_ + cls];
+      const std::uint32_t fallback = transitions_[failure[state] * class_count_ + cls];
+      if (next == kNoState) {
+        next = fallback;
+      } else {
+        failure[next] = fallback;
+        output_links_[next] = terminals_[fallback].empty() ? output_links_[fallback] : fallback;
+        queue.push_back(next);
+      }
+    }
   }
 }
 
 /**
- * @brief Prettifies a line using the prettify maps.
+ * @brief Prettifies a line.
+ *
+ * The line is scanned once to find which patterns occur in it. A replacement only changes the occurrences which overlap
+ * the replaced text, so only the text around it is scanned again. Occurrences which are destroyed by a replacement are
+ * skipped, as the line is searched for each pattern before replacing it.
  *
  * @param s Line to be prettified
  */
-void PrettifyLine(std::string& s) {
-  // do replacement for syntactical pairs
-  for (const auto& p_replace : kSyntaxReplaceSet) {
-    auto cmp = s.find(p_replace.first);
-    if (cmp != std::string::npos) {
-      s.replace(cmp, p_replace.first.length(), p_replace.second);
-    }
-  }
+void ReplacementAutomaton::Apply(std::string& s) const {
+  thread_local std::vector<char> present;
+  present.assign(replacements_.size(), 0);
+  Scan(s, 0, s.size(), 0, &present);
 
-  // do replacement for normal variables
-  for (const auto& p_replace : NormVarReplaceSet) {
-    auto cmp = s.find(p_replace.first);
-    if (cmp != std::string::npos) {
-      s.replace(cmp, p_replace.first.length(), p_replace.second);
+  for (std::size_t i = 0; i < replacements_.size(); ++i) {
+    if (!present[i]) {
+      continue;
     }
-  }
 
-  // do replacement for boolean variables
-  for (const auto& p_replace : BoolVarReplaceSet) {
-    auto cmp = s.find(p_replace.first);
-    if (cmp != std::string::npos) {
-      s.replace(cmp, p_replace.first.length(), p_replace.second);
+    const Replacement& r = replacements_[i];
+    auto cmp = s.find(r.pattern);
+    if (cmp == std::string::npos) {
+      continue;
+    }
+    s.replace(cmp, r.pattern.length(), r.replacement);
+    Rescan(s, cmp, r.replacement.length(), i + 1, &present);
 
-      // also replace the boolean values
+    // also replace the boolean values
+    if (r.is_bool) {
       for (const auto& p_bool : kBoolReplaceSet) {
         auto val = s.find(p_bool.first);
         if (val != std::string::npos) {
           s.replace(val, p_bool.first.size(), p_bool.second);
+          Rescan(s, val, p_bool.second.length(), i + 1, &present);
           break;
         }
       }
     }
   }
+}
+
+/**
+ * @brief Finds the occurrences of patterns which overlap a replaced part of a line.
+ *
+ * @param s Line to scan
+ * @param pos Position of the replaced part
+ * @param length Length of the replaced part
+ * @param first Index of the first replacement to consider
+ * @param present Flags to set for every replacement whose pattern occurs in the line
+ */
+void ReplacementAutomaton::Rescan(const std::string& s, std::size_t pos, std::size_t length, std::size_t first,
+                                  std::vector<char>* const present) const {
+  const std::size_t margin = max_pattern_length_ == 0 ? 0 : max_pattern_length_ - 1;
+  const std::size_t begin = pos - std::min(pos, margin);
+  const std::size_t end = std::min(s.size(), pos + length + margin);
+  Scan(s, begin, end, first, present);
+}
+
+/**
+ * @brief Finds which patterns occur in part of a line.
+ *
+ * @param s Line to scan
+ * @param begin Start of the part to scan
+ * @param end End of the part to scan
+ * @param first Index of the first replacement to consider
+ * @param present Flags to set for every replacement whose pattern occurs in the part
+ */
+void ReplacementAutomaton::Scan(const std::string& s, std::size_t begin, std::size_t end, std::size_t first,
+                                std::vector<char>* const present) const {
+  for (auto i : empty_patterns_) {
+    if (i >= first) {
+      (*present)[i] = 1;
+    }
+  }
+
+  std::uint32_t state = 0;
+  for (std::size_t pos = begin; pos < end; ++pos) {
+    state = transitions_[state * class_count_ + byte_classes_[static_cast<unsigned char>(s[pos])]];
+    for (std::uint32_t out = terminals_[state].empty() ? output_links_[state] : state; out != kNoState;
+         out = output_links_[out]) {
+      for (auto i : terminals_[out]) {
+        if (i >= first) {
+          (*present)[i] = 1;
+        }
+      }
+    }
+  }
+}
+
+namespace {
+/**
+ * @brief A replacement pair of the built-in prettify tables.
+ */
+struct DefaultReplacement {
+  const char* section;
+  const char* field;
+  const char* value;
+};
+
+// generated from the bundled prettify file at build time; defines kDefaultReplacements
+#include "prettify_tables.inc"
+
+/**
+ * @brief Reads a section of replacement pairs from a prettify file.
+ *
+ * @param cf Prettify file
+ * @param section Name of the section
+ * @param desc Description of the fields replaced by the section
+ * @return Replacement pairs of the section, or an empty set if the section does not exist
+ */
+auto ReadReplaceSet(ConfigFile& cf, const std::string& section, const std::string& desc) -> ReplaceSet {
+  auto replace_set = ReplaceSet();
+  try {
+    const std::map<std::string, std::string>& replace = cf.GetSection(section);
+    for (auto&& set : replace) {
+      replace_set.emplace(set.first, set.second);
+    }
+  } catch (std::runtime_error& rt_ex) {
+    LOG_W("Section \"" + section + "\" not found. Will not replace " + desc + " fields");
+
+    // no need to handle it
+  }
+  return replace_set;
+}
+
+/**
+ * @brief Compiles all replacement sets into an automaton, in the order they are applied.
+ *
+ * @param norm_replace_set Replacement pairs for normal variables
+ * @param bool_replace_set Replacement pairs for boolean variables
+ * @param lotus_replace_set Replacement pairs for path variables (/...)
+ * @return Compiled automaton
+ */
+auto CompileReplacements(const ReplaceSet& norm_replace_set, const ReplaceSet& bool_replace_set,
+                         const ReplaceSet& lotus_replace_set) -> std::unique_ptr<const ReplacementAutomaton> {
+  auto replacements = std::vector<Replacement>();
+  for (const auto& p : kSyntaxReplaceSet) {
+    replacements.push_back({p.first, p.second, false});
+  }
+  for (const auto& p : norm_replace_set) {
+    replacements.push_back({p.first, p.second, false});
+  }
+  for (const auto& p : bool_replace_set) {
+    replacements.push_back({p.first, p.second, true});
+  }
+  for (const auto& p : lotus_replace_set) {
+    replacements.push_back({p.first, p.second, false});
+  }
+
+  return std::make_unique<const ReplacementAutomaton>(std::move(replacements));
+}
+}  // namespace
+
+/**
+ * @brief Constructs a Prettifier from the built-in prettify tables.
+ *
+ * The built-in tables are generated from the bundled prettify file at build time, so no file needs to be read.
+ */
+Prettifier::Prettifier() {
+  auto norm_replace_set = ReplaceSet();
+  auto bool_replace_set = ReplaceSet();
+  auto lotus_replace_set = ReplaceSet();
+
+  for (auto&& r : kDefaultReplacements) {
+    const std::string section = r.section;
+    if (section == "normal") {
+      norm_replace_set[r.field] = r.value;
+    } else if (section == "bool") {
+      bool_replace_set[r.field] = r.value;
+    } else if (section == "lotus") {
+      lotus_replace_set[r.field] = r.value;
+    }
+  }
+
+  automaton_ = CompileReplacements(norm_replace_set, bool_replace_set, lotus_replace_set);
+}
+
+/**
+ * @brief Parse prettify file.
+ *
+ * This constructor will attempt to read, and if successful, parse the prettify pairs from the file. Otherwise, only
+ * syntactical constants are replaced.
+ *
+ * @param filename Filename of the prettify file
+ */
+Prettifier::Prettifier(const std::string& filename) {
+  PROFILE_ZONE("Prettifier::Prettifier");
+  auto norm_replace_set = ReplaceSet();
+  auto bool_replace_set = ReplaceSet();
+  auto lotus_replace_set = ReplaceSet();
+
+  ConfigFile cf(filename);
+  if (cf.ReadFromFile()) {
+    LOG_D("Prettify file is valid");
+
+    norm_replace_set = ReadReplaceSet(cf, "normal", "normal");
+    bool_replace_set = ReadReplaceSet(cf, "bool", "boolean");
+    lotus_replace_set = ReadReplaceSet(cf, "lotus", "item");
+  } else {
+    LOG_D("Prettify file is invalid. Will not replace fields.");
+  }
+
+  automaton_ = CompileReplacements(norm_replace_set, bool_replace_set, lotus_replace_set);
+}
+
+Prettifier::~Prettifier() = default;
+
+/**
+ * @brief Prettifies a line using the prettify maps.
+ *
+ * @param s Line to be prettified
+ */
+void Prettifier::PrettifyLine(std::string& s) const {
+  PROFILE_ZONE("Prettifier::PrettifyLine");
+  if (s.size() > kMemoMaxLineLength) {
+    memo_misses_.fetch_add(1, std::memory_order_relaxed);
+    automaton_->Apply(s);
+    return;
+  }
+
+  const std::uint64_t hash = XxHash64(s.data(), s.size());
+  MemoShard& shard = memo_[(hash >> 32) % kMemoShardCount];
+  const std::size_t slot_index = hash % kMemoSlotCount;
 
-  // do replacement for path variables
-  for (const auto& p_replace : LotusVarReplaceSet) {
-    auto cmp = s.find(p_replace.first);
-    if (cmp != std::string::npos) {
-      s.replace(cmp, p_replace.first.length(), p_replace.second);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.slots.empty()) {
+      const MemoSlot& slot = shard.slots[slot_index];
+
+      // the raw line is compared as well, as different lines may have the same hash
+      if (slot.is_used && slot.hash == hash && slot.raw == s) {
+        s = slot.pretty;
+        memo_hits_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
     }
   }
+
+  memo_misses_.fetch_add(1, std::memory_order_relaxed);
+  std::string raw = s;
+  automaton_->Apply(s);
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.slots.empty()) {
+    shard.slots.resize(kMemoSlotCount);
+  }
+  MemoSlot& slot = shard.slots[slot_index];
+  slot.is_used = true;
+  slot.hash = hash;
+  slot.raw = std::move(raw);
+  slot.pretty = s;
+}
+
+/**
+ * @brief Retrieves the counters of the memo table.
+ *
+ * @return Number of memo table hits and misses since construction
+ */
+auto Prettifier::GetMemoStats() const -> MemoStats {
+  return {memo_hits_.load(std::memory_order_relaxed), memo_misses_.load(std::memory_order_relaxed)};
 }
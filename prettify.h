@@ -7,10 +7,94 @@
 #ifndef WARFRAME_PACKAGES_DEPARSER_PRETTIFY_H_
 #define WARFRAME_PACKAGES_DEPARSER_PRETTIFY_H_
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
-void ParsePrettify(const std::string& filename);
-void PrettifyLine(std::string& s);
+class ReplacementAutomaton;
+
+/**
+ * Replacement pairs for prettifying lines, read from a prettify file.
+ *
+ * A Prettifier is immutable once constructed, so a single instance can be shared between threads without locking.
+ * To reload the replacement pairs, construct a new instance and publish it in place of the old one.
+ *
+ * Prettified lines are memoized in a bounded table keyed by the hash of the raw line, as many lines are repeated
+ * verbatim across packages. The table is split into shards with separate locks, so that concurrent callers rarely
+ * contend with each other.
+ */
+class Prettifier {
+ public:
+  /**
+   * @brief Counters of the memo table.
+   */
+  struct MemoStats {
+    /**
+     * @brief Number of lines found in the memo table.
+     */
+    std::uint64_t hits;
+    /**
+     * @brief Number of lines which are prettified from scratch.
+     */
+    std::uint64_t misses;
+  };
+
+  Prettifier();
+  explicit Prettifier(const std::string& filename);
+  ~Prettifier();
+
+  Prettifier(const Prettifier&) = delete;
+  auto operator=(const Prettifier&) -> Prettifier& = delete;
+
+  void PrettifyLine(std::string& s) const;
+
+  auto GetMemoStats() const -> MemoStats;
+
+ private:
+  /**
+   * @brief Number of shards of the memo table.
+   */
+  static constexpr std::size_t kMemoShardCount = 16;
+  /**
+   * @brief Number of slots in each shard of the memo table.
+   */
+  static constexpr std::size_t kMemoSlotCount = 1024;
+  /**
+   * @brief Maximum length of lines which are memoized.
+   */
+  static constexpr std::size_t kMemoMaxLineLength = 256;
+
+  /**
+   * @brief A memoized line.
+   */
+  struct MemoSlot {
+    bool is_used = false;
+    std::uint64_t hash = 0;
+    std::string raw;
+    std::string pretty;
+  };
+
+  /**
+   * @brief A shard of the memo table. Each line maps to a single slot, which is overwritten by later lines.
+   */
+  struct MemoShard {
+    std::mutex mutex;
+    /**
+     * @brief Slots of the shard, allocated when the first line is memoized.
+     */
+    std::vector<MemoSlot> slots;
+  };
+
+  std::unique_ptr<const ReplacementAutomaton> automaton_;
+
+  mutable std::array<MemoShard, kMemoShardCount> memo_;
+  mutable std::atomic<std::uint64_t> memo_hits_{0};
+  mutable std::atomic<std::uint64_t> memo_misses_{0};
+};
 
 #endif  // WARFRAME_PACKAGES_DEPARSER_PRETTIFY_H_
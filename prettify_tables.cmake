@@ -0,0 +1,82 @@
+# Generates the built-in prettify tables from a prettify file.
+#
+# Usage: cmake -DINPUT=<prettify file> -DOUTPUT=<generated file> -P prettify_tables.cmake
+#
+# Lines are parsed the same way as ConfigFile::ReadFromFile: section headers are enclosed in brackets, fields are
+# split at the first '=', and lines outside of any section or without a '=' are ignored.
+
+if (NOT DEFINED INPUT OR NOT DEFINED OUTPUT)
+    message(FATAL_ERROR "INPUT and OUTPUT must be defined")
+endif ()
+
+# Escapes a string to be used as a C++ string literal
+function(escape_literal out str)
+    string(REPLACE "\\" "\\\\" str "${str}")
+    string(REPLACE "\"" "\\\"" str "${str}")
+    string(REPLACE "?" "\\?" str "${str}")
+    string(REPLACE "\t" "\\t" str "${str}")
+    set(${out} "${str}" PARENT_SCOPE)
+endfunction()
+
+file(READ "${INPUT}" contents)
+string(REPLACE "\r" "" contents "${contents}")
+
+# lines are split by searching for newlines, as CMake lists cannot hold arbitrary text
+set(section "")
+set(entries "")
+set(entry_count 0)
+while (NOT contents STREQUAL "")
+    string(FIND "${contents}" "\n" eol)
+    if (eol EQUAL -1)
+        set(line "${contents}")
+        set(contents "")
+    else ()
+        string(SUBSTRING "${contents}" 0 ${eol} line)
+        math(EXPR next "${eol} + 1")
+        string(SUBSTRING "${contents}" ${next} -1 contents)
+    endif ()
+
+    string(LENGTH "${line}" length)
+    if (length EQUAL 0)
+        continue()
+    endif ()
+
+    string(SUBSTRING "${line}" 0 1 first)
+    math(EXPR last_pos "${length} - 1")
+    string(SUBSTRING "${line}" ${last_pos} 1 last)
+    if (first STREQUAL "[" AND last STREQUAL "]" AND length GREATER 1)
+        math(EXPR section_length "${length} - 2")
+        string(SUBSTRING "${line}" 1 ${section_length} section)
+        continue()
+    endif ()
+
+    string(FIND "${line}" "=" equal_pos)
+    if (equal_pos EQUAL -1 OR section STREQUAL "")
+        continue()
+    endif ()
+
+    string(SUBSTRING "${line}" 0 ${equal_pos} field)
+    math(EXPR value_pos "${equal_pos} + 1")
+    string(SUBSTRING "${line}" ${value_pos} -1 value)
+
+    escape_literal(section_literal "${section}")
+    escape_literal(field_literal "${field}")
+    escape_literal(value_literal "${value}")
+    string(APPEND entries "    {\"${section_literal}\", \"${field_literal}\", \"${value_literal}\"},\n")
+    math(EXPR entry_count "${entry_count} + 1")
+endwhile ()
+
+get_filename_component(input_name "${INPUT}" NAME)
+set(generated "// Generated from ${input_name} by prettify_tables.cmake. Do not edit.\n\n")
+string(APPEND generated "const std::array<DefaultReplacement, ${entry_count}> kDefaultReplacements = {{\n")
+string(APPEND generated "${entries}")
+string(APPEND generated "}};\n")
+
+# only touch the output if it changes, to avoid needless recompilation
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+    if (previous STREQUAL generated)
+        return()
+    endif ()
+endif ()
+file(WRITE "${OUTPUT}" "${generated}")
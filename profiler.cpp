@@ -0,0 +1,662 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for Profiler class.
+//
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "allocation_tracker.h"
+#include "perf_counters.h"
+
+namespace {
+/**
+ * @brief Number of histogram buckets per power of two, as a power of two.
+ */
+constexpr unsigned kSubBucketBits = 2;
+/**
+ * @brief Number of histogram buckets, covering all 64-bit durations.
+ */
+constexpr std::size_t kBucketCount = std::size_t{64} << kSubBucketBits;
+
+/**
+ * @brief Finds the histogram bucket of a duration.
+ *
+ * Durations are bucketed on a logarithmic scale, with @c kSubBucketBits bits of precision after the leading bit.
+ *
+ * @param ns Duration in nanoseconds
+ * @return Index of the bucket
+ */
+auto GetBucket(std::uint64_t ns) -> std::size_t {
+  if (ns < (std::uint64_t{1} << kSubBucketBits)) {
+    return ns;
+  }
+
+  unsigned exponent = 0;
+  for (std::uint64_t v = ns; v > 1; v >>= 1) {
+    ++exponent;
+  }
+  const std::uint64_t sub = (ns >> (exponent - kSubBucketBits)) & ((std::uint64_t{1} << kSubBucketBits) - 1);
+  return (std::size_t{exponent} << kSubBucketBits) | sub;
+}
+
+/**
+ * @brief Finds the smallest duration of a histogram bucket.
+ *
+ * @param bucket Index of the bucket
+ * @return Duration in nanoseconds
+ */
+auto GetBucketLowerBound(std::size_t bucket) -> std::uint64_t {
+  if (bucket < (std::size_t{1} << kSubBucketBits)) {
+    return bucket;
+  }
+
+  const std::size_t exponent = bucket >> kSubBucketBits;
+  const std::uint64_t sub = bucket & ((std::size_t{1} << kSubBucketBits) - 1);
+  return ((std::uint64_t{1} << kSubBucketBits) | sub) << (exponent - kSubBucketBits);
+}
+}  // namespace
+
+struct Profiler::Node {
+  const char* name = "";
+  Node* parent = nullptr;
+  std::vector<std::unique_ptr<Node>> children;
+
+  std::uint64_t count = 0;
+  std::uint64_t total_ns = 0;
+  std::uint64_t min_ns = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t max_ns = 0;
+  std::array<std::uint64_t, kBucketCount> buckets{};
+
+  /**
+   * @brief Number of calls in which hardware events were counted.
+   */
+  std::uint64_t counted_count = 0;
+  PerfCounters::Values counter_totals{};
+  /**
+   * @brief Values of the counters when the zone was last entered, if they could be read.
+   */
+  PerfCounters::Values counter_start{};
+  bool is_counting = false;
+  std::uint64_t bytes = 0;
+
+  std::uint64_t alloc_count = 0;
+  std::uint64_t alloc_bytes = 0;
+  /**
+   * @brief Largest growth of heap memory held by the thread during a single call.
+   */
+  std::uint64_t peak_live_bytes = 0;
+  /**
+   * @brief Allocation statistics of the thread when the zone was last entered.
+   */
+  AllocationTracker::Stats alloc_start{};
+  /**
+   * @brief Peak of heap memory held by the thread before the zone was last entered.
+   */
+  std::int64_t outer_peak_live_bytes = 0;
+
+  /**
+   * @brief Finds a child zone by name, creating it if it does not exist.
+   *
+   * @param child_name Name of the child zone
+   * @return Child zone
+   */
+  auto GetChild(const char* child_name) -> Node* {
+    for (auto&& c : children) {
+      if (c->name == child_name || std::strcmp(c->name, child_name) == 0) {
+        return c.get();
+      }
+    }
+
+    children.emplace_back(std::make_unique<Node>());
+    children.back()->name = child_name;
+    children.back()->parent = this;
+    return children.back().get();
+  }
+
+  /**
+   * @brief Adds the statistics of a zone to this zone, including all children.
+   *
+   * @param other Zone to merge
+   */
+  void Merge(const Node& other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    min_ns = std::min(min_ns, other.min_ns);
+    max_ns = std::max(max_ns, other.max_ns);
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+      buckets[i] += other.buckets[i];
+    }
+    counted_count += other.counted_count;
+    for (std::size_t i = 0; i < PerfCounters::kEventCount; ++i) {
+      counter_totals[i] += other.counter_totals[i];
+    }
+    bytes += other.bytes;
+    alloc_count += other.alloc_count;
+    alloc_bytes += other.alloc_bytes;
+    peak_live_bytes = std::max(peak_live_bytes, other.peak_live_bytes);
+
+    for (auto&& c : other.children) {
+      GetChild(c->name)->Merge(*c);
+    }
+  }
+
+  /**
+   * @brief Estimates a percentile of the durations of this zone.
+   *
+   * @param p Percentile between 0 and 1
+   * @return Duration in nanoseconds
+   */
+  auto GetPercentile(double p) const -> std::uint64_t {
+    const auto target = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+      seen += buckets[i];
+      if (seen >= target) {
+        // use the middle of the bucket, but never report a value outside of the observed range
+        const std::uint64_t lower = GetBucketLowerBound(i);
+        const std::uint64_t upper = i + 1 < kBucketCount ? GetBucketLowerBound(i + 1) : max_ns;
+        return std::max(min_ns, std::min(max_ns, lower + (upper - lower) / 2));
+      }
+    }
+    return max_ns;
+  }
+};
+
+std::atomic<bool> Profiler::is_enabled_{false};
+bool Profiler::is_report_enabled_ = false;
+bool Profiler::is_counters_enabled_ = false;
+bool Profiler::is_trace_enabled_ = false;
+std::string Profiler::trace_filename_;
+
+namespace {
+/**
+ * @brief Span of a zone, as recorded for the trace.
+ */
+struct TraceEvent {
+  const char* name;
+  /**
+   * @brief Start of the span in nanoseconds, relative to @c trace_epoch.
+   */
+  std::uint64_t begin_ns;
+  std::uint64_t duration_ns;
+};
+
+/**
+ * @brief Zones recorded by a single thread.
+ */
+struct ThreadData {
+  /**
+   * @brief Sequential ID of the thread, in the order threads first enter a zone.
+   */
+  unsigned id;
+  Profiler::Node root;
+  std::vector<TraceEvent> events;
+  /**
+   * @brief Hardware performance counters of the thread, or @c nullptr if they are not available.
+   */
+  std::unique_ptr<PerfCounters> counters;
+};
+
+/**
+ * @brief Data of all running threads which have entered a zone.
+ */
+std::vector<std::unique_ptr<ThreadData>> thread_data;
+/**
+ * @brief Data of all exited threads which recorded trace events, without their zones and counters.
+ */
+std::vector<std::unique_ptr<ThreadData>> exited_thread_data;
+/**
+ * @brief Zones of all exited threads, merged by zone name.
+ */
+Profiler::Node exited_root;
+/**
+ * @brief Number of threads which have entered a zone so far.
+ */
+unsigned thread_count = 0;
+std::mutex thread_data_mutex;
+
+/**
+ * @brief Data of the current thread.
+ */
+thread_local ThreadData* current_thread_data = nullptr;
+/**
+ * @brief Innermost zone of the current thread.
+ */
+thread_local Profiler::Node* current_node = nullptr;
+
+/**
+ * Releases the data of a thread when it exits.
+ *
+ * Worker threads are created for every parallel operation, so the zones of an exited thread are merged into
+ * @c exited_root, and its performance counters are closed. Only its trace events are kept.
+ */
+class ThreadExitHandler {
+ public:
+  ThreadExitHandler() = default;
+  ThreadExitHandler(ThreadExitHandler&&) = delete;
+  ThreadExitHandler(const ThreadExitHandler&) = delete;
+  auto operator=(ThreadExitHandler&&) noexcept -> ThreadExitHandler& = delete;
+  auto operator=(const ThreadExitHandler&) -> ThreadExitHandler& = delete;
+  ~ThreadExitHandler() {
+    if (current_thread_data == nullptr) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(thread_data_mutex);
+    auto it = std::find_if(thread_data.begin(), thread_data.end(),
+                           [](const std::unique_ptr<ThreadData>& t) { return t.get() == current_thread_data; });
+    if (it != thread_data.end()) {
+      exited_root.Merge((*it)->root);
+      if (!(*it)->events.empty()) {
+        (*it)->root.children.clear();
+        (*it)->counters = nullptr;
+        exited_thread_data.push_back(std::move(*it));
+      }
+      thread_data.erase(it);
+    }
+
+    current_thread_data = nullptr;
+    current_node = nullptr;
+  }
+};
+
+/**
+ * @brief Handler releasing the data of the current thread. Only constructed once the thread enters a zone.
+ */
+thread_local ThreadExitHandler thread_exit_handler;
+
+/**
+ * @brief Time which trace events are relative to.
+ */
+std::chrono::steady_clock::time_point trace_epoch;
+
+/**
+ * @brief Escapes a string to be used in a JSON string.
+ *
+ * @param s String to escape
+ * @return Escaped string
+ */
+auto EscapeJson(const std::string& s) -> std::string {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+/**
+ * @brief Gets all called children of a zone, ordered by total time.
+ *
+ * @param node Zone to get the children of
+ * @return Children of the zone
+ */
+auto GetSortedChildren(const Profiler::Node& node) -> std::vector<const Profiler::Node*> {
+  auto children = std::vector<const Profiler::Node*>();
+  for (auto&& c : node.children) {
+    if (c->count != 0) {
+      children.push_back(c.get());
+    }
+  }
+  std::sort(children.begin(), children.end(),
+            [](const Profiler::Node* a, const Profiler::Node* b) { return a->total_ns > b->total_ns; });
+  return children;
+}
+
+/**
+ * @brief Outputs a zone and all its children, ordered by total time.
+ *
+ * @param os Stream to output to
+ * @param node Zone to output
+ * @param depth Depth of the zone in the tree
+ */
+void OutputNode(std::ostream& os, const Profiler::Node& node, unsigned depth) {
+  auto zone_name = std::string(2 * depth, ' ') + node.name;
+  auto to_us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+  os << std::left << std::setw(48) << zone_name << std::right << std::setw(10) << node.count << std::setw(12)
+     << static_cast<double>(node.total_ns) / 1e6 << std::setw(12) << to_us(node.total_ns / node.count)
+     << std::setw(12) << to_us(node.min_ns) << std::setw(12) << to_us(node.GetPercentile(0.5)) << std::setw(12)
+     << to_us(node.GetPercentile(0.9)) << std::setw(12) << to_us(node.GetPercentile(0.99)) << std::setw(12)
+     << to_us(node.max_ns) << '\n';
+
+  for (auto&& c : GetSortedChildren(node)) {
+    OutputNode(os, *c, depth + 1);
+  }
+}
+
+/**
+ * @brief Outputs the hardware events of a zone and all its children, ordered by total time.
+ *
+ * Events are only normalized by the bytes processed if the zone reports them.
+ *
+ * @param os Stream to output to
+ * @param node Zone to output
+ * @param depth Depth of the zone in the tree
+ */
+void OutputCounterNode(std::ostream& os, const Profiler::Node& node, unsigned depth) {
+  auto zone_name = std::string(2 * depth, ' ') + node.name;
+  const auto& totals = node.counter_totals;
+  const double mb = static_cast<double>(node.bytes) / (1024.0 * 1024.0);
+  auto to_m = [](std::uint64_t n) { return static_cast<double>(n) / 1e6; };
+  auto per_mb = [&](std::uint64_t n) {
+    return node.bytes == 0 ? std::string("-") : std::to_string(static_cast<std::uint64_t>(static_cast<double>(n) / mb));
+  };
+
+  os << std::left << std::setw(48) << zone_name << std::right;
+  if (node.counted_count == 0) {
+    os << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(8) << "-" << std::setw(12) << "-" << std::setw(16)
+       << "-" << std::setw(16) << "-" << '\n';
+  } else {
+    const double ipc = totals[PerfCounters::kCycles] == 0
+                           ? 0.0
+                           : static_cast<double>(totals[PerfCounters::kInstructions]) /
+                                 static_cast<double>(totals[PerfCounters::kCycles]);
+    os << std::setw(12) << to_m(totals[PerfCounters::kCycles]) << std::setw(12)
+       << to_m(totals[PerfCounters::kInstructions]) << std::setw(8) << ipc << std::setw(12) << mb << std::setw(16)
+       << per_mb(totals[PerfCounters::kCacheMisses]) << std::setw(16) << per_mb(totals[PerfCounters::kBranchMisses])
+       << '\n';
+  }
+
+  for (auto&& c : GetSortedChildren(node)) {
+    OutputCounterNode(os, *c, depth + 1);
+  }
+}
+
+/**
+ * @brief Outputs the heap allocations of a zone and all its children, ordered by total time.
+ *
+ * @param os Stream to output to
+ * @param node Zone to output
+ * @param depth Depth of the zone in the tree
+ */
+void OutputAllocationNode(std::ostream& os, const Profiler::Node& node, unsigned depth) {
+  auto zone_name = std::string(2 * depth, ' ') + node.name;
+  auto to_kb = [](std::uint64_t bytes) { return static_cast<double>(bytes) / 1024.0; };
+
+  os << std::left << std::setw(48) << zone_name << std::right << std::setw(10) << node.count << std::setw(14)
+     << node.alloc_count << std::setw(14) << node.alloc_count / node.count << std::setw(14) << to_kb(node.alloc_bytes)
+     << std::setw(14) << to_kb(node.peak_live_bytes) << '\n';
+
+  for (auto&& c : GetSortedChildren(node)) {
+    OutputAllocationNode(os, *c, depth + 1);
+  }
+}
+
+/**
+ * @brief Merges the zones of all threads by zone name.
+ *
+ * @param merged Zone to merge the roots of all threads into
+ */
+void MergeThreadData(Profiler::Node* const merged) {
+  std::lock_guard<std::mutex> lock(thread_data_mutex);
+  for (auto&& c : exited_root.children) {
+    merged->GetChild(c->name)->Merge(*c);
+  }
+  for (auto&& t : thread_data) {
+    for (auto&& c : t->root.children) {
+      merged->GetChild(c->name)->Merge(*c);
+    }
+  }
+}
+}  // namespace
+
+void Profiler::Enable() {
+  is_report_enabled_ = true;
+  RegisterAtExit();
+}
+
+void Profiler::EnableCounters() {
+  // probe the counters once, so that unavailable counters are reported up front instead of in every thread
+  PerfCounters probe;
+  static_cast<void>(probe);
+
+  is_counters_enabled_ = true;
+  Enable();
+}
+
+void Profiler::EnableAllocationTracking() {
+  AllocationTracker::Enable();
+  RegisterAtExit();
+}
+
+void Profiler::SetRecording(bool is_recording) { is_enabled_ = is_recording; }
+
+void Profiler::EnableTrace(const std::string& filename) {
+  trace_filename_ = filename;
+  trace_epoch = std::chrono::steady_clock::now();
+  is_trace_enabled_ = true;
+  RegisterAtExit();
+}
+
+auto Profiler::Enter(const char* name) -> Node* {
+  if (current_thread_data == nullptr) {
+    std::lock_guard<std::mutex> lock(thread_data_mutex);
+    thread_data.emplace_back(std::make_unique<ThreadData>());
+    current_thread_data = thread_data.back().get();
+    current_thread_data->id = ++thread_count;
+    current_node = &current_thread_data->root;
+
+    // constructs the handler, so that the data is released when the thread exits
+    static_cast<void>(&thread_exit_handler);
+
+    if (is_counters_enabled_) {
+      try {
+        current_thread_data->counters = std::make_unique<PerfCounters>();
+      } catch (std::runtime_error&) {
+        // zones of this thread are only timed
+      }
+    }
+  }
+
+  current_node = current_node->GetChild(name);
+  current_node->is_counting =
+      current_thread_data->counters != nullptr && current_thread_data->counters->Read(&current_node->counter_start);
+  if (AllocationTracker::IsEnabled()) {
+    current_node->alloc_start = AllocationTracker::GetThreadStats();
+    current_node->outer_peak_live_bytes = AllocationTracker::ResetThreadPeak();
+  }
+  return current_node;
+}
+
+void Profiler::Exit(Node* const node, std::uint64_t elapsed_ns) {
+  PerfCounters::Values counter_end{};
+  if (node->is_counting && current_thread_data->counters->Read(&counter_end)) {
+    ++node->counted_count;
+    for (std::size_t i = 0; i < PerfCounters::kEventCount; ++i) {
+      node->counter_totals[i] += counter_end[i] - std::min(counter_end[i], node->counter_start[i]);
+    }
+  }
+
+  if (AllocationTracker::IsEnabled()) {
+    const AllocationTracker::Stats alloc_end = AllocationTracker::GetThreadStats();
+    node->alloc_count += alloc_end.count - node->alloc_start.count;
+    node->alloc_bytes += alloc_end.bytes - node->alloc_start.bytes;
+    const std::int64_t growth = std::max<std::int64_t>(alloc_end.peak_live_bytes - node->alloc_start.live_bytes, 0);
+    node->peak_live_bytes = std::max(node->peak_live_bytes, static_cast<std::uint64_t>(growth));
+    AllocationTracker::RestoreThreadPeak(node->outer_peak_live_bytes);
+  }
+
+  ++node->count;
+  node->total_ns += elapsed_ns;
+  node->min_ns = std::min(node->min_ns, elapsed_ns);
+  node->max_ns = std::max(node->max_ns, elapsed_ns);
+  ++node->buckets[GetBucket(elapsed_ns)];
+
+  if (is_trace_enabled_) {
+    const auto end = std::chrono::steady_clock::now() - trace_epoch;
+    const auto end_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end).count());
+    current_thread_data->events.push_back({node->name, end_ns - std::min(end_ns, elapsed_ns), elapsed_ns});
+  }
+
+  current_node = node->parent;
+}
+
+void Profiler::AddBytes(std::uint64_t bytes) {
+  if (current_node != nullptr) {
+    current_node->bytes += bytes;
+  }
+}
+
+void Profiler::OutputReport(std::ostream& os) {
+  Node merged;
+  MergeThreadData(&merged);
+
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::fixed << std::setprecision(1);
+
+  os << "Profile Report" << '\n';
+  os << std::left << std::setw(48) << "Zone" << std::right << std::setw(10) << "Calls" << std::setw(12) << "Total ms"
+     << std::setw(12) << "Mean us" << std::setw(12) << "Min us" << std::setw(12) << "P50 us" << std::setw(12)
+     << "P90 us" << std::setw(12) << "P99 us" << std::setw(12) << "Max us" << '\n';
+
+  const auto roots = GetSortedChildren(merged);
+  for (auto&& r : roots) {
+    OutputNode(os, *r, 0);
+  }
+
+  if (is_counters_enabled_) {
+    os << '\n' << "Hardware Counters" << '\n';
+    os << std::left << std::setw(48) << "Zone" << std::right << std::setw(12) << "Cycles M" << std::setw(12)
+       << "Instrs M" << std::setw(8) << "IPC" << std::setw(12) << "MB" << std::setw(16) << "Cache miss/MB"
+       << std::setw(16) << "Branch miss/MB" << '\n';
+    for (auto&& r : roots) {
+      OutputCounterNode(os, *r, 0);
+    }
+  }
+  os << std::flush;
+
+  os.flags(flags);
+  os.precision(precision);
+
+  if (AllocationTracker::IsEnabled()) {
+    os << '\n';
+    OutputAllocationReport(os);
+  }
+}
+
+void Profiler::OutputAllocationReport(std::ostream& os) {
+  Node merged;
+  MergeThreadData(&merged);
+
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::fixed << std::setprecision(1);
+
+  os << "Allocation Report" << '\n';
+  os << std::left << std::setw(48) << "Zone" << std::right << std::setw(10) << "Calls" << std::setw(14) << "Allocs"
+     << std::setw(14) << "Allocs/call" << std::setw(14) << "Total KB" << std::setw(14) << "Peak KB" << '\n';
+  for (auto&& r : GetSortedChildren(merged)) {
+    OutputAllocationNode(os, *r, 0);
+  }
+  os << std::flush;
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+auto Profiler::GetZoneTotals(const std::string& name) -> ZoneTotals {
+  auto totals = ZoneTotals{0, 0};
+
+  std::lock_guard<std::mutex> lock(thread_data_mutex);
+  auto nodes = std::vector<const Node*>{&exited_root};
+  for (auto&& t : thread_data) {
+    nodes.push_back(&t->root);
+  }
+  while (!nodes.empty()) {
+    const Node* node = nodes.back();
+    nodes.pop_back();
+    if (node->name == name) {
+      totals.count += node->count;
+      totals.total_ns += node->total_ns;
+    }
+    for (auto&& c : node->children) {
+      nodes.push_back(c.get());
+    }
+  }
+
+  return totals;
+}
+
+bool Profiler::WriteTrace(const std::string& filename) {
+  auto ofs = std::ofstream(filename);
+  if (!ofs) {
+    return false;
+  }
+
+  // timestamps and durations of trace events are in microseconds
+  auto to_us = [](std::uint64_t ns) { return std::to_string(ns / 1000) + "." + std::to_string(ns / 100 % 10); };
+
+  ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool is_first = true;
+  std::lock_guard<std::mutex> lock(thread_data_mutex);
+  auto all_thread_data = std::vector<const ThreadData*>();
+  for (auto&& t : exited_thread_data) {
+    all_thread_data.push_back(t.get());
+  }
+  for (auto&& t : thread_data) {
+    all_thread_data.push_back(t.get());
+  }
+  std::sort(all_thread_data.begin(), all_thread_data.end(),
+            [](const ThreadData* a, const ThreadData* b) { return a->id < b->id; });
+
+  for (auto&& t : all_thread_data) {
+    const std::string tid = std::to_string(t->id);
+
+    ofs << (is_first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+        << ",\"args\":{\"name\":\"Thread " << tid << "\"}}";
+    is_first = false;
+
+    for (auto&& e : t->events) {
+      ofs << ",\n{\"name\":\"" << EscapeJson(e.name) << "\",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":" << to_us(e.begin_ns)
+          << ",\"dur\":" << to_us(e.duration_ns) << ",\"pid\":1,\"tid\":" << tid << "}";
+    }
+  }
+  ofs << "\n]}\n";
+
+  return static_cast<bool>(ofs);
+}
+
+/**
+ * @brief Enables recording of zones, and registers the outputs to be written at exit.
+ */
+void Profiler::RegisterAtExit() {
+  static std::atomic<bool> is_registered{false};
+  if (!is_registered.exchange(true)) {
+    std::atexit(&Profiler::OutputAtExit);
+  }
+  is_enabled_ = true;
+}
+
+/**
+ * @brief Outputs the report to stderr and writes the trace, if enabled. Registered to be called at exit.
+ */
+void Profiler::OutputAtExit() {
+  if (is_report_enabled_) {
+    OutputReport(std::cerr);
+  }
+  if (is_trace_enabled_ && !WriteTrace(trace_filename_)) {
+    std::cerr << trace_filename_ << ": Cannot write trace file." << std::endl;
+  }
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for profiling scoped zones.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_PROFILER_H_
+#define WARFRAME_PACKAGES_DEPARSER_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "timer.h"
+
+/**
+ * Static hierarchical profiler.
+ *
+ * Each thread records the zones it enters into its own tree, where the children of a zone are the zones entered while
+ * it is active. The trees of all threads are merged by zone name when the report is generated. Zones entered by
+ * worker threads therefore appear at the top level of the report.
+ *
+ * Zones can also be recorded as a trace of Chrome trace events, which can be opened in a trace viewer. Each thread
+ * appends the spans of its zones to its own buffer, and the buffers of all threads are merged when the trace is written.
+ *
+ * Zones can optionally count hardware events of their thread, such as cycles and cache misses. Zones may also report
+ * the number of bytes they process, so that the events can be normalized by the amount of input.
+ *
+ * If allocation tracking is enabled, zones also record the heap allocations made by their thread, and the peak of heap
+ * memory held by their thread while they are active.
+ *
+ * When the profiler is disabled, entering a zone only costs an atomic load.
+ */
+class Profiler {
+ public:
+  /**
+   * @brief Statistics of a zone at a position in the zone tree.
+   */
+  struct Node;
+
+  /**
+   * @brief Statistics of a zone, summed over all threads and positions in the zone tree.
+   */
+  struct ZoneTotals {
+    std::uint64_t count;
+    std::uint64_t total_ns;
+  };
+
+  Profiler() = delete;
+  Profiler(Profiler&&) = delete;
+  Profiler(const Profiler&) = delete;
+  auto operator=(Profiler&&) noexcept -> Profiler& = delete;
+  auto operator=(const Profiler&) -> Profiler& = delete;
+  ~Profiler() = delete;
+
+  /**
+   * Enables profiling, and registers the report to be output to stderr at exit.
+   */
+  static void Enable();
+  /**
+   * Enables tracing, and registers the trace to be written at exit.
+   *
+   * @param filename Name of the trace file
+   */
+  static void EnableTrace(const std::string& filename);
+  /**
+   * Enables counting hardware events in each zone, in addition to profiling.
+   *
+   * @throw @c std::runtime_error if hardware performance counters are not available
+   */
+  static void EnableCounters();
+  /**
+   * Enables tracking heap allocations in each zone.
+   *
+   * @throw @c std::runtime_error if allocation tracking is not supported
+   */
+  static void EnableAllocationTracking();
+  /**
+   * Starts or stops recording zones, without outputting anything at exit.
+   *
+   * Zones which are active when recording stops are still recorded when they exit.
+   *
+   * @param is_recording Whether to record zones
+   */
+  static void SetRecording(bool is_recording);
+  /**
+   * @return Whether zones are being recorded
+   */
+  static auto IsEnabled() -> bool { return is_enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * Enters a zone in the current thread.
+   *
+   * @param name Name of the zone. Must outlive the profiler.
+   * @return Node of the zone
+   */
+  static auto Enter(const char* name) -> Node*;
+  /**
+   * Exits the innermost zone of the current thread.
+   *
+   * @param node Node returned by the matching @c Enter
+   * @param elapsed_ns Time spent in the zone in nanoseconds
+   */
+  static void Exit(Node* node, std::uint64_t elapsed_ns);
+  /**
+   * Adds to the number of bytes processed by the innermost zone of the current thread.
+   *
+   * @param bytes Number of bytes
+   */
+  static void AddBytes(std::uint64_t bytes);
+
+  /**
+   * Outputs the statistics of all zones recorded so far.
+   *
+   * @param os Stream to output to
+   */
+  static void OutputReport(std::ostream& os);
+  /**
+   * Outputs the heap allocations of all zones recorded so far.
+   *
+   * @param os Stream to output to
+   */
+  static void OutputAllocationReport(std::ostream& os);
+  /**
+   * Gets the statistics of a zone recorded so far.
+   *
+   * @param name Name of the zone
+   * @return Statistics of all calls of the zone
+   */
+  static auto GetZoneTotals(const std::string& name) -> ZoneTotals;
+  /**
+   * Writes the spans of all zones recorded so far as Chrome trace events.
+   *
+   * @param filename Name of the trace file
+   * @return True if successful
+   */
+  static bool WriteTrace(const std::string& filename);
+
+ private:
+  static void RegisterAtExit();
+  static void OutputAtExit();
+
+  static std::atomic<bool> is_enabled_;
+  static bool is_report_enabled_;
+  static bool is_counters_enabled_;
+  static bool is_trace_enabled_;
+  static std::string trace_filename_;
+};
+
+/**
+ * Zone which is profiled from construction to destruction.
+ */
+class ProfileZone {
+ public:
+  /**
+   * @param name Name of the zone. Must outlive the profiler.
+   */
+  explicit ProfileZone(const char* name) {
+    if (Profiler::IsEnabled()) {
+      node_ = Profiler::Enter(name);
+      timer_.Start();
+    }
+  }
+  ProfileZone(ProfileZone&&) = delete;
+  ProfileZone(const ProfileZone&) = delete;
+  auto operator=(ProfileZone&&) noexcept -> ProfileZone& = delete;
+  auto operator=(const ProfileZone&) -> ProfileZone& = delete;
+  ~ProfileZone() {
+    if (node_ != nullptr) {
+      timer_.Stop();
+      Profiler::Exit(node_, static_cast<std::uint64_t>(timer_.GetTime()));
+    }
+  }
+
+ private:
+  Profiler::Node* node_ = nullptr;
+  Timer timer_;
+};
+
+#define PROFILE_ZONE_CONCAT(a, b) a##b
+#define PROFILE_ZONE_VARIABLE(line) PROFILE_ZONE_CONCAT(profile_zone_, line)
+
+/**
+ * Profiles the rest of the enclosing scope as a zone.
+ */
+#define PROFILE_ZONE(name) const ProfileZone PROFILE_ZONE_VARIABLE(__LINE__)(name)
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_PROFILER_H_
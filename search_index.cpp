@@ -0,0 +1,384 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for SearchIndex class.
+//
+
+#include "search_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "log.h"
+#include "mapped_file.h"
+#include "profiler.h"
+#include "util.h"
+
+namespace {
+const char kIndexMagic[] = "WFPDIDX1";
+constexpr std::size_t kIndexMagicLength = sizeof(kIndexMagic) - 1;
+
+/**
+ * @brief Location of the body of a package within the file.
+ */
+struct BodyRange {
+  std::uint32_t id;
+  const char* begin;
+  const char* end;
+};
+
+using TermPostings = std::pair<std::string, std::vector<std::uint32_t>>;
+
+/**
+ * @brief Checks whether a character separates two tokens.
+ *
+ * @param c Character to check
+ * @return True if @p c is a separator
+ */
+inline bool IsSeparator(char c) {
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '=':
+    case ',':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case '"':
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Extracts all search terms from a line of a package body.
+ *
+ * @param begin Start of the line
+ * @param end End of the line, excluding the newline character
+ * @param terms Vector to append the terms to
+ */
+void TokenizeLine(const char* begin, const char* end, std::vector<std::string>* const terms) {
+  while (begin != end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+  while (begin != end && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+    --end;
+  }
+  if (begin == end) {
+    return;
+  }
+
+  // key-value pairs, excluding the opening of arrays and objects
+  const char* eq = std::find(begin, end, '=');
+  if (eq != begin && eq != end) {
+    const auto value = std::string(eq + 1, end);
+    if (!value.empty() && value != "{" && value != "[" && value != "{}" && value != "[]") {
+      terms->emplace_back(begin, end);
+    }
+  }
+
+  // individual tokens, such as keys, values and paths
+  for (const char* it = begin; it != end;) {
+    while (it != end && IsSeparator(*it)) {
+      ++it;
+    }
+    const char* token_begin = it;
+    while (it != end && !IsSeparator(*it)) {
+      ++it;
+    }
+    if (token_begin != it) {
+      terms->emplace_back(token_begin, it);
+    }
+  }
+}
+
+/**
+ * @brief Locates the body of every package in a file.
+ *
+ * @param file Mapped input file
+ * @param header_names Sorted list of all headers in the file
+ * @return Body ranges, sorted by package index
+ */
+auto FindBodyRanges(const MappedFile& file, const std::vector<const std::string*>& header_names)
+    -> std::vector<BodyRange> {
+  auto ranges = std::vector<BodyRange>();
+  bool is_open = false;
+
+  const char* const file_end = file.GetData() + file.GetSize();
+  for (const char* line = file.GetData(); line < file_end;) {
+    const char* line_end = std::find(line, file_end, '\n');
+    const char* next = line_end == file_end ? file_end : line_end + 1;
+
+    const auto str = std::string(line, line_end);
+    const auto start_of_category = str.find("FullPackageName=");
+    if (start_of_category != std::string::npos) {
+      std::string category = str.substr(start_of_category + 16);
+      if (!category.empty() && category.back() == '\r') {
+        category.pop_back();
+      }
+
+      auto search = std::lower_bound(header_names.begin(), header_names.end(), category,
+                                     [](const std::string* a, const std::string& b) { return *a < b; });
+      if (is_open) {
+        ranges.back().end = line;
+      }
+      is_open = search != header_names.end() && **search == category;
+      if (is_open) {
+        ranges.push_back({static_cast<std::uint32_t>(search - header_names.begin()), next, file_end});
+      }
+    }
+
+    line = next;
+  }
+
+  std::stable_sort(ranges.begin(), ranges.end(),
+                   [](const BodyRange& a, const BodyRange& b) { return a.id < b.id; });
+  return ranges;
+}
+}  // namespace
+
+auto SearchIndex::Build(const MappedFile& file, const std::vector<const std::string*>& header_names)
+    -> std::unique_ptr<SearchIndex> {
+  PROFILE_ZONE("SearchIndex::Build");
+  LOG_D("SearchIndex::Build");
+
+  const std::vector<BodyRange> ranges = FindBodyRanges(file, header_names);
+
+  // tokenize each chunk of packages on its own thread. as chunks are sorted by package index, the posting lists of
+  // each chunk are also sorted
+  auto chunk_postings = std::vector<std::vector<TermPostings>>(GetWorkerCount());
+  ParallelChunks(ranges.size(), [&](std::size_t begin, std::size_t end, unsigned worker) {
+    auto postings = std::unordered_map<std::string, std::vector<std::uint32_t>>();
+    auto terms = std::vector<std::string>();
+
+    for (std::size_t i = begin; i < end; ++i) {
+      const BodyRange& r = ranges[i];
+
+      terms.clear();
+      for (const char* line = r.begin; line < r.end;) {
+        const char* line_end = std::find(line, r.end, '\n');
+        TokenizeLine(line, line_end, &terms);
+        line = line_end == r.end ? r.end : line_end + 1;
+      }
+      std::sort(terms.begin(), terms.end());
+      terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+      for (auto&& t : terms) {
+        auto& list = postings[t];
+        if (list.empty() || list.back() != r.id) {
+          list.push_back(r.id);
+        }
+      }
+    }
+
+    auto& sorted = chunk_postings[worker];
+    sorted.reserve(postings.size());
+    for (auto&& p : postings) {
+      sorted.emplace_back(p.first, std::move(p.second));
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const TermPostings& a, const TermPostings& b) { return a.first < b.first; });
+  });
+
+  // merge the sorted term lists of all chunks
+  auto index = std::unique_ptr<SearchIndex>(new SearchIndex());
+  index->package_count_ = header_names.size();
+
+  auto cursors = std::vector<std::size_t>(chunk_postings.size(), 0);
+  while (true) {
+    const std::string* next_term = nullptr;
+    for (std::size_t c = 0; c < chunk_postings.size(); ++c) {
+      if (cursors[c] < chunk_postings[c].size() &&
+          (next_term == nullptr || chunk_postings[c][cursors[c]].first < *next_term)) {
+        next_term = &chunk_postings[c][cursors[c]].first;
+      }
+    }
+    if (next_term == nullptr) {
+      break;
+    }
+
+    index->terms_.emplace_back(*next_term);
+    index->posting_offsets_.emplace_back(index->postings_.size());
+    for (std::size_t c = 0; c < chunk_postings.size(); ++c) {
+      if (cursors[c] < chunk_postings[c].size() && chunk_postings[c][cursors[c]].first == index->terms_.back()) {
+        for (const std::uint32_t id : chunk_postings[c][cursors[c]].second) {
+          // a package may span two chunks if it is defined more than once
+          if (index->postings_.size() == index->posting_offsets_.back() || index->postings_.back() != id) {
+            index->postings_.push_back(id);
+          }
+        }
+        ++cursors[c];
+      }
+    }
+  }
+  index->posting_offsets_.emplace_back(index->postings_.size());
+
+  LOG_D("SearchIndex::Build: Indexed " + std::to_string(index->terms_.size()) + " terms");
+  return index;
+}
+
+auto SearchIndex::Load(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime,
+                       std::size_t package_count) -> std::unique_ptr<SearchIndex> {
+  LOG_D("SearchIndex::Load(" + filename + ")");
+
+  std::unique_ptr<MappedFile> file;
+  try {
+    file = std::make_unique<MappedFile>(filename);
+  } catch (std::runtime_error& ex_runtime) {
+    LOG_D("SearchIndex::Load: " + std::string(ex_runtime.what()));
+    return nullptr;
+  }
+
+  const char* it = file->GetData();
+  const char* const end = it + file->GetSize();
+  if (file->GetSize() < kIndexMagicLength || std::memcmp(it, kIndexMagic, kIndexMagicLength) != 0) {
+    LOG_W("SearchIndex::Load: Invalid index file");
+    return nullptr;
+  }
+  it += kIndexMagicLength;
+
+  std::uint64_t saved_size;
+  std::uint64_t saved_mtime;
+  std::uint64_t saved_count;
+  std::uint64_t term_count;
+  if (!ReadVarint(&it, end, &saved_size) || !ReadVarint(&it, end, &saved_mtime) ||
+      !ReadVarint(&it, end, &saved_count) || !ReadVarint(&it, end, &term_count)) {
+    LOG_W("SearchIndex::Load: Truncated index file");
+    return nullptr;
+  }
+  if (saved_size != file_size || static_cast<std::int64_t>(saved_mtime) != file_mtime ||
+      saved_count != package_count) {
+    LOG_I("SearchIndex::Load: Index is stale");
+    return nullptr;
+  }
+
+  auto index = std::unique_ptr<SearchIndex>(new SearchIndex());
+  index->package_count_ = package_count;
+  // every term takes at least one byte, so a corrupted term count cannot exhaust memory here
+  index->terms_.reserve(std::min<std::uint64_t>(term_count, file->GetSize()));
+
+  for (std::uint64_t t = 0; t < term_count; ++t) {
+    std::uint64_t length;
+    if (!ReadVarint(&it, end, &length) || static_cast<std::uint64_t>(end - it) < length) {
+      LOG_W("SearchIndex::Load: Truncated index file");
+      return nullptr;
+    }
+    index->terms_.emplace_back(it, length);
+    it += length;
+
+    std::uint64_t count;
+    if (!ReadVarint(&it, end, &count)) {
+      LOG_W("SearchIndex::Load: Truncated index file");
+      return nullptr;
+    }
+    index->posting_offsets_.emplace_back(index->postings_.size());
+
+    std::uint64_t id = 0;
+    for (std::uint64_t p = 0; p < count; ++p) {
+      std::uint64_t delta;
+      if (!ReadVarint(&it, end, &delta)) {
+        LOG_W("SearchIndex::Load: Truncated index file");
+        return nullptr;
+      }
+      id += delta;
+      if (id >= package_count) {
+        LOG_W("SearchIndex::Load: Invalid package index");
+        return nullptr;
+      }
+      index->postings_.push_back(static_cast<std::uint32_t>(id));
+    }
+  }
+  index->posting_offsets_.emplace_back(index->postings_.size());
+
+  return index;
+}
+
+bool SearchIndex::Save(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime) const {
+  LOG_D("SearchIndex::Save(" + filename + ")");
+
+  std::string buffer(kIndexMagic, kIndexMagicLength);
+  WriteVarint(&buffer, file_size);
+  WriteVarint(&buffer, static_cast<std::uint64_t>(file_mtime));
+  WriteVarint(&buffer, package_count_);
+  WriteVarint(&buffer, terms_.size());
+
+  for (std::size_t t = 0; t < terms_.size(); ++t) {
+    WriteVarint(&buffer, terms_[t].size());
+    buffer.append(terms_[t]);
+
+    // posting lists are delta-encoded, as they are sorted
+    WriteVarint(&buffer, posting_offsets_[t + 1] - posting_offsets_[t]);
+    std::uint32_t prev = 0;
+    for (std::size_t p = posting_offsets_[t]; p < posting_offsets_[t + 1]; ++p) {
+      WriteVarint(&buffer, postings_[p] - prev);
+      prev = postings_[p];
+    }
+  }
+
+  auto ofs = std::ofstream(filename, std::ios::binary);
+  if (!ofs) {
+    return false;
+  }
+  ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  return static_cast<bool>(ofs);
+}
+
+auto SearchIndex::Lookup(const std::string& term) const -> std::vector<std::uint32_t> {
+  auto result = std::vector<std::uint32_t>();
+
+  if (!term.empty() && term.back() == '*') {
+    // prefix search: merge the posting lists of all terms beginning with the prefix
+    const std::string prefix = term.substr(0, term.size() - 1);
+    for (auto it = std::lower_bound(terms_.begin(), terms_.end(), prefix);
+         it != terms_.end() && it->compare(0, prefix.size(), prefix) == 0; ++it) {
+      const auto t = static_cast<std::size_t>(it - terms_.begin());
+      result.insert(result.end(), postings_.begin() + static_cast<std::ptrdiff_t>(posting_offsets_[t]),
+                    postings_.begin() + static_cast<std::ptrdiff_t>(posting_offsets_[t + 1]));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  } else {
+    auto it = std::lower_bound(terms_.begin(), terms_.end(), term);
+    if (it != terms_.end() && *it == term) {
+      const auto t = static_cast<std::size_t>(it - terms_.begin());
+      result.assign(postings_.begin() + static_cast<std::ptrdiff_t>(posting_offsets_[t]),
+                    postings_.begin() + static_cast<std::ptrdiff_t>(posting_offsets_[t + 1]));
+    }
+  }
+
+  return result;
+}
+
+auto SearchIndex::Search(const std::vector<std::string>& terms) const -> std::vector<std::uint32_t> {
+  auto result = std::vector<std::uint32_t>();
+
+  for (auto it = terms.begin(); it != terms.end(); ++it) {
+    std::vector<std::uint32_t> matches = Lookup(*it);
+    if (it == terms.begin()) {
+      result = std::move(matches);
+    } else {
+      auto intersection = std::vector<std::uint32_t>();
+      std::set_intersection(result.begin(), result.end(), matches.begin(), matches.end(),
+                            std::back_inserter(intersection));
+      result = std::move(intersection);
+    }
+
+    if (result.empty()) {
+      break;
+    }
+  }
+
+  return result;
+}
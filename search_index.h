@@ -0,0 +1,92 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Inverted index over the contents of packages.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_SEARCH_INDEX_H_
+#define WARFRAME_PACKAGES_DEPARSER_SEARCH_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * Inverted index which maps tokens and key-value pairs in package bodies to the packages containing them.
+ *
+ * Packages are identified by their index in the lexicographically sorted list of headers.
+ */
+class SearchIndex {
+ public:
+  /**
+   * Builds an index from the contents of a file.
+   *
+   * @param file Mapped input file
+   * @param header_names Sorted list of all headers in the file
+   * @return Built index
+   */
+  static auto Build(const MappedFile& file, const std::vector<const std::string*>& header_names)
+      -> std::unique_ptr<SearchIndex>;
+  /**
+   * Loads an index previously saved by @c Save.
+   *
+   * @param filename Filename of the saved index
+   * @param file_size Size of the indexed file, for checking whether the saved index is stale
+   * @param file_mtime Modification time of the indexed file, for checking whether the saved index is stale
+   * @param package_count Number of packages in the indexed file
+   * @return Loaded index, or @c nullptr if the saved index is missing, stale or corrupted
+   */
+  static auto Load(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime,
+                   std::size_t package_count) -> std::unique_ptr<SearchIndex>;
+
+  /**
+   * Saves the index to a file.
+   *
+   * @param filename Filename to save to
+   * @param file_size Size of the indexed file
+   * @param file_mtime Modification time of the indexed file
+   * @return True if successful
+   */
+  bool Save(const std::string& filename, std::uint64_t file_size, std::int64_t file_mtime) const;
+
+  /**
+   * Finds all packages matching all given terms.
+   *
+   * A term may either be a token (e.g. @c /Lotus/Upgrades/Mods/Rifle), or a key-value pair
+   * (e.g. @c ProductCategory=Pistols). A term ending with @c * matches all terms beginning with it.
+   *
+   * @param terms Terms to search for
+   * @return Sorted list of matching package indices
+   */
+  auto Search(const std::vector<std::string>& terms) const -> std::vector<std::uint32_t>;
+
+  /**
+   * @return Number of distinct terms in the index
+   */
+  auto GetTermCount() const -> std::size_t { return terms_.size(); }
+
+ private:
+  SearchIndex() = default;
+
+  auto Lookup(const std::string& term) const -> std::vector<std::uint32_t>;
+
+  std::size_t package_count_ = 0;
+
+  /**
+   * @brief Sorted list of all terms.
+   */
+  std::vector<std::string> terms_;
+  /**
+   * @brief Offset of the posting list of each term into @c postings_, with a sentinel at the end.
+   */
+  std::vector<std::size_t> posting_offsets_;
+  /**
+   * @brief Posting lists of all terms, each sorted by package index.
+   */
+  std::vector<std::uint32_t> postings_;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_SEARCH_INDEX_H_
@@ -0,0 +1,32 @@
+# Checks that bench_compare flags a clear slowdown with the fewest repetitions it allows, and refuses fewer.
+#
+# Usage: cmake -DBENCH_COMPARE=<bench_compare> -DDATA_DIR=<directory> -P bench_compare.cmake
+#
+# The old and new results have 4 repetitions each, where every new sample is slower than every old one. The few
+# results have 3 repetitions, for which no ordering of the samples is significant at the default alpha of 0.05.
+
+foreach (var BENCH_COMPARE DATA_DIR)
+    if (NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} must be defined")
+    endif ()
+endforeach ()
+
+execute_process(COMMAND "${BENCH_COMPARE}" "${DATA_DIR}/bench_compare_old.json" "${DATA_DIR}/bench_compare_new.json"
+        RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+if (NOT result EQUAL 1)
+    message(FATAL_ERROR "Expected exit status 1 for a regression, got ${result}:\n${output}")
+endif ()
+string(FIND "${output}" "REGRESSION" pos)
+if (pos EQUAL -1)
+    message(FATAL_ERROR "Regression not reported:\n${output}")
+endif ()
+
+execute_process(COMMAND "${BENCH_COMPARE}" "${DATA_DIR}/bench_compare_few.json" "${DATA_DIR}/bench_compare_few.json"
+        RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+if (NOT result EQUAL 2)
+    message(FATAL_ERROR "Expected exit status 2 for too few repetitions, got ${result}:\n${output}")
+endif ()
+string(FIND "${output}" "--repetitions=4" pos)
+if (pos EQUAL -1)
+    message(FATAL_ERROR "Required repetitions not reported:\n${output}")
+endif ()
@@ -0,0 +1,34 @@
+# Checks the rows of compare-many for headers which are removed and added back, or modified, across three files.
+#
+# Usage: cmake -DDEPARSER=<deparser> -DDATA_DIR=<directory> -DWORK_DIR=<directory> -P compare_many.cmake
+#
+# The first header is missing from the second file only, and the second header is modified in the third file.
+
+foreach (var DEPARSER DATA_DIR WORK_DIR)
+    if (NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} must be defined")
+    endif ()
+endforeach ()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+foreach (f 0 1 2)
+    configure_file("${DATA_DIR}/compare_many_${f}.txt" "${WORK_DIR}/${f}.txt" COPYONLY)
+endforeach ()
+
+execute_process(COMMAND "${DEPARSER}" -D -f 0.txt -I -- compare-many 0.txt 1.txt 2.txt
+        WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "compare-many failed:\n${output}")
+endif ()
+
+set(expected_rows
+        "/Lotus/Powersuits/Excalibur/Excalibur\t0\t2\t1,2\n"
+        "/Lotus/Weapons/Tenno/Pistol/Lato\t0\t2\t2\n"
+        "3 headers, 2 not identical across all files.")
+foreach (row ${expected_rows})
+    string(FIND "${output}" "${row}" pos)
+    if (pos EQUAL -1)
+        message(FATAL_ERROR "Expected row not found: ${row}\nOutput:\n${output}")
+    endif ()
+endforeach ()
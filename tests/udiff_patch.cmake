@@ -0,0 +1,51 @@
+# Checks that the output of udiff applies to the old file with patch(1), and that the result is the new file.
+#
+# Usage: cmake -DDEPARSER=<deparser> -DPATCH=<patch> -DOLD=<old file> -DNEW=<new file> -DWORK_DIR=<directory>
+#              -P udiff_patch.cmake
+#
+# The check is repeated with LF and CRLF line endings, and with and without context lines.
+
+foreach (var DEPARSER PATCH OLD NEW WORK_DIR)
+    if (NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} must be defined")
+    endif ()
+endforeach ()
+
+file(READ "${OLD}" old_contents)
+file(READ "${NEW}" new_contents)
+string(REPLACE "\r" "" old_contents "${old_contents}")
+string(REPLACE "\r" "" new_contents "${new_contents}")
+
+foreach (eol LF CRLF)
+    if (eol STREQUAL "CRLF")
+        string(REPLACE "\n" "\r\n" old_contents "${old_contents}")
+        string(REPLACE "\n" "\r\n" new_contents "${new_contents}")
+    endif ()
+
+    foreach (context 0 3)
+        set(dir "${WORK_DIR}/${eol}-${context}")
+        file(REMOVE_RECURSE "${dir}")
+        file(MAKE_DIRECTORY "${dir}")
+        file(WRITE "${dir}/old.txt" "${old_contents}")
+        file(WRITE "${dir}/new.txt" "${new_contents}")
+        file(WRITE "${dir}/patched.txt" "${old_contents}")
+
+        execute_process(COMMAND "${DEPARSER}" -D -f new.txt -I -- udiff context=${context} old.txt out.diff
+                WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+        if (NOT result EQUAL 0 OR NOT EXISTS "${dir}/out.diff")
+            message(FATAL_ERROR "${eol}, context=${context}: udiff failed:\n${output}")
+        endif ()
+
+        execute_process(COMMAND "${PATCH}" patched.txt out.diff
+                WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+        if (NOT result EQUAL 0)
+            message(FATAL_ERROR "${eol}, context=${context}: patch failed:\n${output}")
+        endif ()
+
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files patched.txt new.txt
+                WORKING_DIRECTORY "${dir}" RESULT_VARIABLE result)
+        if (NOT result EQUAL 0)
+            message(FATAL_ERROR "${eol}, context=${context}: patched file differs from the new file, see ${dir}")
+        endif ()
+    endforeach ()
+endforeach ()
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Implementations for LiteralSearcher class.
+//
+
+#include "text_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // defined(__SSE2__)
+
+LiteralSearcher::LiteralSearcher(std::string needle) : needle_(std::move(needle)) {}
+
+auto LiteralSearcher::Find(const char* begin, const char* const end) const -> const char* {
+  const std::size_t n = needle_.size();
+  if (n == 0) {
+    return begin;
+  }
+  if (static_cast<std::size_t>(end - begin) < n) {
+    return end;
+  }
+  if (n == 1) {
+    const void* p = std::memchr(begin, needle_.front(), static_cast<std::size_t>(end - begin));
+    return p == nullptr ? end : static_cast<const char*>(p);
+  }
+
+#if defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(needle_.front());
+  const __m128i last = _mm_set1_epi8(needle_.back());
+
+  // process 16 candidate positions at a time, as long as the last character of all candidates is in the buffer
+  for (; begin + 16 + n - 1 <= end; begin += 16) {
+    const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + n - 1));
+    auto mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+
+    while (mask != 0) {
+      const auto bit = static_cast<unsigned>(__builtin_ctz(mask));
+      if (std::memcmp(begin + bit + 1, needle_.data() + 1, n - 2) == 0) {
+        return begin + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif  // defined(__SSE2__)
+
+  // scalar search for the remaining positions
+  return std::search(begin, end, needle_.begin(), needle_.end());
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2018 David Mak. All rights reserved.
+// Licensed under MIT.
+//
+// Utilities for searching literal strings in large buffers.
+//
+
+#ifndef WARFRAME_PACKAGES_DEPARSER_TEXT_SEARCH_H_
+#define WARFRAME_PACKAGES_DEPARSER_TEXT_SEARCH_H_
+
+#include <string>
+
+/**
+ * Searcher for a literal string.
+ *
+ * When SSE2 is available, candidate positions are found by comparing the first and last characters of the needle
+ * against 16 positions of the haystack at once, and only the candidates are verified byte-by-byte.
+ */
+class LiteralSearcher {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param needle String to search for
+   */
+  explicit LiteralSearcher(std::string needle);
+
+  /**
+   * Finds the first occurrence of the needle in a buffer.
+   *
+   * @param begin Start of the buffer
+   * @param end End of the buffer
+   * @return Pointer to the first occurrence, or @p end if the needle is not found
+   */
+  auto Find(const char* begin, const char* end) const -> const char*;
+
+ private:
+  std::string needle_;
+};
+
+#endif  // WARFRAME_PACKAGES_DEPARSER_TEXT_SEARCH_H_
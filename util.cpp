@@ -6,12 +6,20 @@
 
 #include "util.h"
 
-#include <fstream>
 #include <iostream>
 #include <iterator>
-#include <limits>
 #include <sstream>
 #include <string>
+#include <thread>
+
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif  // defined(_WIN32)
 
 using std::size_t;
 
@@ -58,21 +66,6 @@ auto JoinToString(const std::vector<std::string>& input, std::string separator)
   return arg.str();
 }
 
-/**
- * @brief Jumps to a certain line in an open @c std::ifstream.
- *
- * @param fs Input file stream
- * @param line Line number
- */
-void GotoLine(std::ifstream& fs, unsigned line) {
-  fs.seekg(std::ios::beg);
-
-  // skip line number of lines
-  for (unsigned it = 0; it < line - 1; ++it) {
-    fs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-  }
-}
-
 /**
  * @brief Converts tabs to spaces in a string.
  *
@@ -86,13 +79,136 @@ void ConvertTabToSpace(std::string& str) {
   }
 }
 
+/**
+ * @brief Retrieves the size and modification time of a file, for checking whether derived files are stale.
+ *
+ * @param filename Name of the file
+ * @param size Size of the file in bytes
+ * @param mtime Modification time of the file
+ * @return True if successful
+ */
+bool GetFileStamp(const std::string& filename, std::uint64_t* const size, std::int64_t* const mtime) {
+  struct stat st{};
+  if (stat(filename.c_str(), &st) != 0) {
+    return false;
+  }
+
+  *size = static_cast<std::uint64_t>(st.st_size);
+  *mtime = st.st_mtime;
+  return true;
+}
+
+/**
+ * @brief Creates a directory if it does not exist.
+ *
+ * @param path Path of the directory
+ * @return True if the directory exists after the call
+ */
+bool MakeDirectory(const std::string& path) {
+#if defined(_WIN32)
+  _mkdir(path.c_str());
+#else
+  mkdir(path.c_str(), 0755);
+#endif  // defined(_WIN32)
+
+  struct stat st{};
+  return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+/**
+ * @brief Truncates a file to the given size.
+ *
+ * @param filename Name of the file
+ * @param size Size of the file in bytes after truncation
+ * @return True if successful
+ */
+bool TruncateFile(const std::string& filename, std::uint64_t size) {
+#if defined(_WIN32)
+  int fd = -1;
+  if (_sopen_s(&fd, filename.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) {
+    return false;
+  }
+  const bool is_truncated = _chsize_s(fd, static_cast<__int64>(size)) == 0;
+  _close(fd);
+  return is_truncated;
+#else
+  return truncate(filename.c_str(), static_cast<off_t>(size)) == 0;
+#endif  // defined(_WIN32)
+}
+
+/**
+ * @brief Appends an unsigned integer to a buffer using a variable-length encoding.
+ *
+ * @param out Buffer to append to
+ * @param value Value to encode
+ */
+void WriteVarint(std::string* const out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads an unsigned integer encoded by @c WriteVarint.
+ *
+ * @param it Pointer to the current position of the buffer. Advanced past the encoded value.
+ * @param end End of the buffer
+ * @param value Decoded value
+ * @return True if successful, false if the buffer ends before the value
+ */
+bool ReadVarint(const char** const it, const char* const end, std::uint64_t* const value) {
+  *value = 0;
+  for (unsigned shift = 0; *it != end && shift < 64; shift += 7) {
+    const auto byte = static_cast<unsigned char>(*(*it)++);
+    *value |= std::uint64_t{byte & 0x7Fu} << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace {
+/**
+ * @brief Whether @c ClearScreen clears the console screen.
+ */
+bool is_clear_screen_enabled = true;
+}  // namespace
+
 /**
  * @brief System-independent function for clearing a console screen.
+ *
+ * Does nothing if clearing has been disabled with @c SetClearScreenEnabled.
  */
 void ClearScreen() {
+  if (!is_clear_screen_enabled) {
+    return;
+  }
+
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
   system("cls");
 #else
   system("clear");
 #endif  // defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 }
+
+/**
+ * @brief Enables or disables clearing the console screen, e.g. when the output is not read from a console.
+ *
+ * @param is_enabled Whether @c ClearScreen clears the console screen
+ */
+void SetClearScreenEnabled(bool is_enabled) {
+  is_clear_screen_enabled = is_enabled;
+}
+
+/**
+ * @brief Gets the number of worker threads to use for parallel operations.
+ *
+ * @return Number of hardware threads, or 1 if it cannot be determined
+ */
+auto GetWorkerCount() -> unsigned {
+  const unsigned count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
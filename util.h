@@ -7,15 +7,55 @@
 #ifndef WARFRAME_PACKAGES_DEPARSER_UTIL_H_
 #define WARFRAME_PACKAGES_DEPARSER_UTIL_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <thread>
 #include <vector>
 
 auto SplitString(std::string input, std::string delimiter, unsigned limit = 0) -> std::vector<std::string>;
 auto JoinToString(const std::vector<std::string>& input, std::string separator) -> std::string;
 
-void GotoLine(std::ifstream& fs, unsigned line);
 void ConvertTabToSpace(std::string& str);
 
+bool GetFileStamp(const std::string& filename, std::uint64_t* size, std::int64_t* mtime);
+bool MakeDirectory(const std::string& path);
+bool TruncateFile(const std::string& filename, std::uint64_t size);
+
+void WriteVarint(std::string* out, std::uint64_t value);
+bool ReadVarint(const char** it, const char* end, std::uint64_t* value);
+
 void ClearScreen();
+void SetClearScreenEnabled(bool is_enabled);
+
+auto GetWorkerCount() -> unsigned;
+
+/**
+ * @brief Splits the range [0, count) into contiguous chunks, and processes each chunk on its own thread.
+ *
+ * The last chunk is processed on the calling thread. This function returns when all chunks are processed.
+ *
+ * @param count Number of elements to process
+ * @param fn Function object accepting (begin, end, worker index) of a chunk
+ */
+template<typename Fn>
+void ParallelChunks(std::size_t count, Fn&& fn) {
+  const std::size_t workers = std::max<std::size_t>(1, std::min<std::size_t>(GetWorkerCount(), count));
+  const std::size_t chunk_size = (count + workers - 1) / std::max<std::size_t>(1, workers);
+
+  std::vector<std::thread> threads;
+  for (std::size_t w = 0; w + 1 < workers; ++w) {
+    const std::size_t begin = w * chunk_size;
+    const std::size_t end = std::min(count, begin + chunk_size);
+    threads.emplace_back([&fn, begin, end, w]() { fn(begin, end, static_cast<unsigned>(w)); });
+  }
+
+  fn(std::min(count, (workers - 1) * chunk_size), count, static_cast<unsigned>(workers - 1));
+
+  for (auto&& t : threads) {
+    t.join();
+  }
+}
 
 #endif  // WARFRAME_PACKAGES_DEPARSER_UTIL_H_